@@ -0,0 +1,155 @@
+// aio.cc
+//	Routines for asynchronous file I/O.  See aio.h.
+//
+//	This file is compiled with either implementation of OpenFile (see
+//	openfile.h), since all it needs of a file is ReadAt and WriteAt;
+//	so the asynchronous OpenFile routines are here too.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "aio.h"
+#include "openfile.h"
+#include "synch.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// AioWorker
+// 	Body of a request's thread.  Need this to be a C routine, because
+//	C++ can't handle pointers to member functions.
+//----------------------------------------------------------------------
+
+static void
+AioWorker(int arg)
+{
+    AioRequest *request = (AioRequest *) arg;
+
+    request->Run();
+}
+
+//----------------------------------------------------------------------
+// AioRequest::AioRequest
+// 	Describe an asynchronous read or write.
+//
+//	"openFile" is the file to read or write.
+//	"data" is the data to write, or where to put the data read; it
+//		must stay put until the request is done.
+//	"length" is how many bytes to transfer.
+//	"offset" is where in the file to start.
+//	"isWrite" is TRUE for a write, FALSE for a read.
+//	"handler" is called with "handlerArg" when the request is done,
+//		by the request's thread, just before Wait returns; or NULL.
+//----------------------------------------------------------------------
+
+AioRequest::AioRequest(OpenFile *openFile, char *data, int length,
+		       int offset, bool isWrite, VoidFunctionPtr handler,
+		       int handlerArg)
+{
+    file = openFile;
+    buffer = data;
+    numBytes = length;
+    position = offset;
+    writing = isWrite;
+    callWhenDone = handler;
+    callArg = handlerArg;
+    userAddr = -1;
+    result = 0;
+    done = FALSE;
+    finished = new Semaphore("aio finished", 0);
+}
+
+AioRequest::~AioRequest()
+{
+    delete finished;
+}
+
+//----------------------------------------------------------------------
+// AioRequest::Start
+// 	Fork a thread to carry out the request, at the priority of the
+//	thread that made it, and return at once.
+//----------------------------------------------------------------------
+
+void
+AioRequest::Start()
+{
+    Thread *worker = new Thread("aio worker", currentThread->getPriority());
+
+    DEBUG('f', "Starting async %s of %d bytes at %d\n",
+	  writing ? "write" : "read", numBytes, position);
+    worker->Fork(AioWorker, (void *) this);
+}
+
+//----------------------------------------------------------------------
+// AioRequest::Run
+// 	Do the read or write, and let the requester know.  Once "finished"
+//	is V'ed, the requester may delete us at any time, so nothing is
+//	touched after that.
+//----------------------------------------------------------------------
+
+void
+AioRequest::Run()
+{
+    if (writing)
+	result = file->WriteAt(buffer, numBytes, position);
+    else
+	result = file->ReadAt(buffer, numBytes, position);
+    DEBUG('f', "Async %s of %d bytes at %d done, %d transferred\n",
+	  writing ? "write" : "read", numBytes, position, result);
+    if (callWhenDone != NULL)
+	(*callWhenDone)(callArg);
+    done = TRUE;
+    finished->V();
+}
+
+//----------------------------------------------------------------------
+// AioRequest::Wait
+// 	Wait until the request is done, if it is not already, and return
+//	how many bytes were transferred.  May be called more than once.
+//----------------------------------------------------------------------
+
+int
+AioRequest::Wait()
+{
+    finished->P();
+    finished->V();			// for the next Wait
+    return result;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::ReadAtAsync/WriteAtAsync
+// 	Start reading/writing a portion of a file, starting at "position",
+//	and return at once.  The caller waits for the request (or is
+//	called back), and then deletes it.
+//
+//	"into" -- the buffer to contain the data to be read from disk
+//	"from" -- the buffer containing the data to be written to disk
+//	"numBytes" -- the number of bytes to transfer
+//	"position" -- the offset within the file of the first byte to be
+//			read/written
+//	"callWhenDone", "callArg" -- called when the request is done, or
+//			NULL
+//----------------------------------------------------------------------
+
+AioRequest *
+OpenFile::ReadAtAsync(char *into, int numBytes, int position,
+		      VoidFunctionPtr callWhenDone, int callArg)
+{
+    AioRequest *request = new AioRequest(this, into, numBytes, position,
+					 FALSE, callWhenDone, callArg);
+
+    request->Start();
+    return request;
+}
+
+AioRequest *
+OpenFile::WriteAtAsync(char *from, int numBytes, int position,
+		       VoidFunctionPtr callWhenDone, int callArg)
+{
+    AioRequest *request = new AioRequest(this, from, numBytes, position,
+					 TRUE, callWhenDone, callArg);
+
+    request->Start();
+    return request;
+}
@@ -0,0 +1,68 @@
+// aio.h 
+//	Data structures for asynchronous file I/O: reads and writes that
+//	return at once, and complete later on, so that a thread can have
+//	many of them in flight at a time.
+//
+//	Each request is carried out by a kernel thread of its own, which
+//	does an ordinary ReadAt or WriteAt, and blocks in the file system
+//	and the disk in place of the thread that asked for it.  So several
+//	requests reach the disk scheduler together (see synchdisk.h), and
+//	can be served in whatever order moves the disk head least.
+//
+//	The thread that made a request finds out it is done by calling
+//	Wait, or by asking IsDone; or it can have a procedure called when
+//	the request is done, from the request's own thread.
+//
+//	User programs make requests with the AioRead and AioWrite system 
+//	calls, and wait for them with AioWait (see syscall.h).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef AIO_H
+#define AIO_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class OpenFile;
+class Semaphore;
+
+// The following class defines one asynchronous read or write.
+
+class AioRequest {
+  public:
+    AioRequest(OpenFile *openFile, char *data, int length, int offset,
+	       bool isWrite, VoidFunctionPtr handler = NULL, 
+	       int handlerArg = 0);	// describe a request; it does not 
+					// start until Start is called
+    ~AioRequest();			// de-allocate a request, which must
+					// be done, or never started
+
+    void Start();			// start a thread to do the request
+    int Wait();				// wait until the request is done;
+					// return the # of bytes transferred
+    bool IsDone() { return done; }
+    char *Buffer() { return buffer; }
+
+    void Run();			 	// body of the request's thread
+
+    int userAddr;			// for AioRead: where the data goes
+					// in the user program's memory; 
+					// -1 otherwise
+
+  private:
+    OpenFile *file;			// the file to read or write
+    char *buffer;			// the data
+    int numBytes;			// how much of it
+    int position;			// where in the file
+    bool writing;
+    VoidFunctionPtr callWhenDone;	// called when the request is done,
+    int callArg;			// with this argument, if not NULL
+    int result;				// # of bytes transferred, once done
+    bool done;				// has the request finished?
+    Semaphore *finished;		// V'ed once it has
+};
+
+#endif // AIO_H
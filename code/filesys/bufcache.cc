@@ -0,0 +1,1039 @@
+// bufcache.cc 
+//	Routines to manage the disk buffer cache.
+//
+//	Every routine here that touches the cache's data structures holds
+//	"lock".  The lock is released only around disk I/O, and only once
+//	the buffer involved is marked busy, so that nobody else uses it 
+//	or chooses it for eviction in the meantime.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "bufcache.h"
+#include "synchdisk.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// CachePolicyNamed, CachePolicyName
+// 	Convert between a replacement policy and its name on the command
+//	line.
+//----------------------------------------------------------------------
+
+static char *policyNames[] = { "lru", "2q", "arc" };
+
+CachePolicy
+CachePolicyNamed(char *name)
+{
+    for (int i = CacheLRU; i <= CacheARC; i++)
+	if (!strcmp(name, policyNames[i]))
+	    return (CachePolicy) i;
+    printf("Unknown cache replacement policy %s: use lru, 2q or arc\n", name);
+    ASSERT(FALSE);
+    return CacheLRU;
+}
+
+char *
+CachePolicyName(CachePolicy policy)
+{
+    return policyNames[policy];
+}
+
+//----------------------------------------------------------------------
+// CacheFlusher
+// 	Body of the flusher thread.  Need this to be a C routine, because
+//	C++ can't handle pointers to member functions.
+//----------------------------------------------------------------------
+
+static void
+CacheFlusher(int arg)
+{
+    BufferCache *cache = (BufferCache *) arg;
+
+    cache->Flusher();
+}
+
+//----------------------------------------------------------------------
+// CachePrefetcher
+// 	Body of the read-ahead thread.
+//----------------------------------------------------------------------
+
+static void
+CachePrefetcher(int arg)
+{
+    BufferCache *cache = (BufferCache *) arg;
+
+    cache->Prefetcher();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::BufferCache
+// 	Initialize a cache of empty buffers, with a hash table of at least
+//	as many chains as buffers.  There are as many ghosts as buffers;
+//	ARC never needs more, and 2Q only half as many.
+//
+//	"cachedDisk" is the disk whose sectors are cached.
+//	"cacheSize" is the number of sectors the cache can hold.
+//	"cachePolicy" says which buffer to evict when the cache is full.
+//	"maxDirtyAge" is how long a buffer may stay dirty before the flusher
+//		thread writes it back; 0 means there is no flusher, and 
+//		buffers are written back only when evicted or synced.
+//
+//	The read-ahead thread is always started; it waits until there is
+//	something to read ahead.
+//----------------------------------------------------------------------
+
+BufferCache::BufferCache(SynchDisk *cachedDisk, int cacheSize, 
+			 CachePolicy cachePolicy, int maxDirtyAge)
+{
+    int numChains;
+
+    ASSERT(cacheSize > 0);
+    disk = cachedDisk;
+    policy = cachePolicy;
+    numBuffers = cacheSize;
+    numPinned = 0;
+    numMisses = 0;
+    flushAge = maxDirtyAge;
+    target = 0;
+    buffers = new CacheBuffer[numBuffers];
+    ghosts = new CacheGhost[numBuffers];
+    unused = new IntrusiveList<CacheBuffer>;
+    recent = new IntrusiveList<CacheBuffer>;
+    frequent = new IntrusiveList<CacheBuffer>;
+    ghostRecent = new IntrusiveList<CacheGhost>;
+    ghostFrequent = new IntrusiveList<CacheGhost>;
+    freeGhosts = new IntrusiveList<CacheGhost>;
+    for (int i = 0; i < numBuffers; i++) {
+	buffers[i].sector = -1;
+	buffers[i].dirty = buffers[i].busy = buffers[i].pinned = FALSE;
+	buffers[i].prefetched = FALSE;
+	buffers[i].writing = FALSE;
+	buffers[i].dirtySince = 0;
+	buffers[i].queue = NULL;
+	buffers[i].lastMiss = 0;
+	buffers[i].hashNext = NULL;
+	unused->Append(&buffers[i]);
+	ghosts[i].sector = -1;
+	ghosts[i].hashNext = NULL;
+	freeGhosts->Append(&ghosts[i]);
+    }
+    for (numChains = 1; numChains < numBuffers; numChains *= 2)
+	;
+    hashMask = numChains - 1;
+    hash = new CacheBuffer *[numChains];
+    ghostHash = new CacheGhost *[numChains];
+    for (int i = 0; i < numChains; i++) {
+	hash[i] = NULL;
+	ghostHash[i] = NULL;
+    }
+    lock = new Lock("buffer cache lock");
+    ioDone = new Condition("buffer cache I/O done");
+    dirtied = new Condition("buffer cache dirtied");
+    readAheadQueue = new int[ReadAheadQueueSize];
+    readAheadHead = readAheadCount = 0;
+    readAheadWanted = new Condition("buffer cache read-ahead wanted");
+    if (flushAge > 0) {
+	Thread *flusher = new Thread("cache flusher");
+
+	flusher->Fork(CacheFlusher, (void *) this);
+    }
+    Thread *prefetcher = new Thread("cache read-ahead");
+
+    prefetcher->Fork(CachePrefetcher, (void *) this);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::~BufferCache
+// 	De-allocate the cache.
+//----------------------------------------------------------------------
+
+BufferCache::~BufferCache()
+{
+    while (unused->Remove() != NULL)
+	;
+    while (recent->Remove() != NULL)
+	;
+    while (frequent->Remove() != NULL)
+	;
+    while (ghostRecent->Remove() != NULL)
+	;
+    while (ghostFrequent->Remove() != NULL)
+	;
+    while (freeGhosts->Remove() != NULL)
+	;
+    delete unused;
+    delete recent;
+    delete frequent;
+    delete ghostRecent;
+    delete ghostFrequent;
+    delete freeGhosts;
+    delete [] hash;
+    delete [] ghostHash;
+    delete [] buffers;
+    delete [] ghosts;
+    delete lock;
+    delete ioDone;
+    delete dirtied;
+    delete [] readAheadQueue;
+    delete readAheadWanted;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::HashInsert, BufferCache::HashRemove
+// 	Put a buffer on the hash chain for its sector, or take it off.
+//----------------------------------------------------------------------
+
+void
+BufferCache::HashInsert(CacheBuffer *buf)
+{
+    CacheBuffer **chain = &hash[buf->sector & hashMask];
+
+    buf->hashNext = *chain;
+    *chain = buf;
+}
+
+void
+BufferCache::HashRemove(CacheBuffer *buf)
+{
+    CacheBuffer **pp;
+
+    for (pp = &hash[buf->sector & hashMask]; *pp != buf; pp = &(*pp)->hashNext)
+	ASSERT(*pp != NULL);
+    *pp = buf->hashNext;
+    buf->hashNext = NULL;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Find
+// 	Return the buffer holding a sector, or NULL if the sector is not 
+//	cached.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Find(int sector)
+{
+    CacheBuffer *buf;
+
+    for (buf = hash[sector & hashMask]; buf != NULL; buf = buf->hashNext)
+	if (buf->sector == sector)
+	    break;
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Lookup
+// 	Return the buffer holding a sector, or NULL if the sector is not 
+//	cached.  If the buffer is busy, wait for its I/O to finish, and
+//	look again -- it may hold a different sector by then.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Lookup(int sector)
+{
+    CacheBuffer *buf;
+
+    for (;;) {
+	buf = Find(sector);
+	if (buf == NULL || !buf->busy)
+	    return buf;
+	ioDone->Wait(lock);
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Touch
+// 	A buffer has just been used again: move it to the most recently 
+//	used end of its list.  Under 2Q and ARC, a buffer used again 
+//	while on A1in or T1 moves to Am or T2 -- unless there has been no 
+//	miss since it was last used.  Reading a file a few bytes at a
+//	time, as Print and Copy do, uses each sector many times in a row;
+//	that is really one use, and counting it as more would let a scan
+//	flush Am or T2.  2Q leaves such a buffer where it is, since A1in
+//	is a FIFO.
+//
+//	(The paper's 2Q never promotes a buffer from A1in; it has to be 
+//	evicted, and missed again while it is a ghost.  But while Am is
+//	empty, A1in is the whole cache, so a sector used every few dozen
+//	misses would never get into Am, and one long scan evicts it.)
+//
+//	The first use of a sector that was read ahead is its first use, 
+//	not a second one.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Touch(CacheBuffer *buf)
+{
+    bool again = (buf->lastMiss != numMisses);	// not the same use
+
+    if (buf->prefetched) {
+	buf->prefetched = FALSE;
+	buf->lastMiss = numMisses;
+	again = FALSE;
+	stats->numReadAheadHits++;
+    }
+
+    if (buf->pinned || (policy == Cache2Q && buf->queue == recent && !again))
+	return;
+    buf->queue->Remove(buf);
+    if (policy != CacheLRU && again)
+	buf->queue = frequent;
+    buf->lastMiss = numMisses;
+    buf->queue->Append(buf);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::GhostLookup, BufferCache::GhostAdd, 
+// BufferCache::GhostRemove
+// 	Find the ghost of an evicted sector; remember an evicted sector at
+//	the most recent end of a ghost list; or forget a ghost.
+//
+//	If every ghost is in use, GhostAdd forgets the oldest one, from 
+//	B2 in preference to B1 (or A1out).
+//----------------------------------------------------------------------
+
+CacheGhost *
+BufferCache::GhostLookup(int sector)
+{
+    CacheGhost *ghost;
+
+    for (ghost = ghostHash[sector & hashMask]; ghost != NULL; 
+	 ghost = ghost->hashNext)
+	if (ghost->sector == sector)
+	    break;
+    return ghost;
+}
+
+void
+BufferCache::GhostAdd(int sector, IntrusiveList<CacheGhost> *ghostList)
+{
+    CacheGhost **chain = &ghostHash[sector & hashMask];
+    CacheGhost *ghost;
+
+    if (freeGhosts->IsEmpty())
+	GhostRemove(ghostFrequent->IsEmpty() ? ghostRecent->Front() 
+					     : ghostFrequent->Front());
+    ghost = freeGhosts->Remove();
+    ghost->sector = sector;
+    ghost->hashNext = *chain;
+    *chain = ghost;
+    ghostList->Append(ghost);
+}
+
+void
+BufferCache::GhostRemove(CacheGhost *ghost)
+{
+    CacheGhost **pp;
+
+    for (pp = &ghostHash[ghost->sector & hashMask]; *pp != ghost; 
+	 pp = &(*pp)->hashNext)
+	ASSERT(*pp != NULL);
+    *pp = ghost->hashNext;
+    ghost->hashNext = NULL;
+    ghost->sector = -1;
+    if (ghostRecent->IsInList(ghost))
+	ghostRecent->Remove(ghost);
+    else
+	ghostFrequent->Remove(ghost);
+    freeGhosts->Append(ghost);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Adapt
+// 	Called once for each miss, before a buffer is chosen to evict.  If
+//	the sector was evicted recently, ARC adapts: a ghost in B1 means 
+//	T1 would have kept it if it were bigger, so the target size of T1 
+//	grows; a ghost in B2 means T2 should have been bigger, so it 
+//	shrinks.  Each step is bigger the smaller the ghost list, as in
+//	the paper.
+//
+// Returns:
+//	The ghost list that remembers the sector, or NULL.  Always NULL
+//	except under ARC.
+//----------------------------------------------------------------------
+
+IntrusiveList<CacheGhost> *
+BufferCache::Adapt(int sector)
+{
+    CacheGhost *ghost;
+    int b1, b2;
+
+    if (policy != CacheARC || (ghost = GhostLookup(sector)) == NULL)
+	return NULL;
+    b1 = ghostRecent->NumInList();
+    b2 = ghostFrequent->NumInList();
+    if (ghostRecent->IsInList(ghost)) {
+	target += (b2 > b1) ? b2 / b1 : 1;
+	if (target > Capacity())
+	    target = Capacity();
+	return ghostRecent;
+    }
+    target -= (b1 > b2) ? b1 / b2 : 1;
+    if (target < 0)
+	target = 0;
+    return ghostFrequent;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ChooseVictim
+// 	Take the buffer to evict next off its list.  Buffers that hold
+//	nothing are used up first.  After that:
+//
+//	   LRU takes the least recently used buffer.
+//	   2Q takes the oldest buffer on A1in if A1in holds more than a
+//		quarter of the cache, else the least recently used on Am.
+//	   ARC takes the least recently used buffer on T1 if T1 is over 
+//		its target size (or at it, if the sector we want is a
+//		ghost in B2), else the least recently used on T2.
+//
+//	If the list chosen is empty, because its buffers are all busy 
+//	or pinned, we take from the other one.
+//
+//	"ghostList" is what Adapt returned for the sector being filled.
+// Returns:
+//	The victim, which still remembers in "queue" which list it came
+//	from; NULL if every buffer is busy or pinned.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::ChooseVictim(IntrusiveList<CacheGhost> *ghostList)
+{
+    IntrusiveList<CacheBuffer> *first, *second;
+    CacheBuffer *buf;
+    int t1 = recent->NumInList();
+
+    if ((buf = unused->Remove()) != NULL)
+	return buf;
+    first = recent;
+    switch (policy) {
+      case Cache2Q:
+	if (t1 <= Capacity() / 4)
+	    first = frequent;
+	break;
+      case CacheARC:
+	if (t1 < target || (t1 == target && ghostList != ghostFrequent)
+	    || t1 == 0)
+	    first = frequent;
+	break;
+      default:
+	break;
+    }
+    second = (first == recent) ? frequent : recent;
+    if ((buf = first->Remove()) == NULL)
+	buf = second->Remove();
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Evicted
+// 	A buffer is about to be given to another sector: remember its old
+//	sector as a ghost.  2Q only remembers sectors evicted from A1in,
+//	and keeps at most half a cache's worth of them.  ARC remembers 
+//	sectors evicted from T1 in B1, and from T2 in B2, and keeps T1 and 
+//	B1 together to at most a cache's worth, as in the paper.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Evicted(CacheBuffer *buf)
+{
+    if (policy == Cache2Q && buf->queue == recent) {
+	GhostAdd(buf->sector, ghostRecent);
+	while (ghostRecent->NumInList() > Capacity() / 2)
+	    GhostRemove(ghostRecent->Front());
+    } else if (policy == CacheARC) {
+	GhostAdd(buf->sector, 
+		 (buf->queue == recent) ? ghostRecent : ghostFrequent);
+	while (recent->NumInList() + ghostRecent->NumInList() > Capacity()
+	       && !ghostRecent->IsEmpty())
+	    GhostRemove(ghostRecent->Front());
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Admit
+// 	A buffer has just been given a sector: choose the list it goes on,
+//	once it is filled.  That is A1in or T1, unless the sector was 
+//	remembered as a ghost -- it was evicted too soon -- in which case
+//	it goes straight to Am or T2.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Admit(CacheBuffer *buf, bool wasGhost)
+{
+    buf->queue = wasGhost ? frequent : recent;
+    buf->lastMiss = numMisses;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Claim
+// 	Give a sector that is not in the cache a buffer: the one the 
+//	replacement policy chooses.  If it is dirty, write it back first,
+//	leaving it in the hash table meanwhile, so that a reader of its
+//	old sector waits for the write rather than reading stale data 
+//	from disk.
+//
+//	A buffer that Sync or the flusher is writing back cannot be used
+//	until the write is done: if its sector were read back in the 
+//	meantime, it would come from the disk without the write.
+//
+//	Whenever we wait, another thread may bring the sector in; if so,
+//	we use its buffer instead.
+//
+//	"sector" is the sector that needs a buffer.
+//	"prefetch" is TRUE if nobody wants the sector yet: it is being
+//		read ahead.  That does not count as a miss.
+//	"wait" is FALSE if we may not release the lock, because we hold
+//		other claimed buffers: rather than wait for a buffer, or 
+//		write one back, give up.
+// Returns:
+//	The buffer now holding "sector", marked busy and on no list; the
+//	caller fills it, and then hands it to Ready.  Or, if someone else
+//	brought the sector in meanwhile, their buffer, which is not busy.
+//	NULL if "wait" is FALSE and no buffer was free to take.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Claim(int sector, bool prefetch, bool wait)
+{
+    CacheBuffer *buf, *other;
+    IntrusiveList<CacheGhost> *ghostList = Adapt(sector);
+    CacheGhost *ghost;
+    bool wasGhost;
+
+    for (;;) {
+	buf = ChooseVictim(ghostList);
+	if (buf != NULL && !buf->writing && !buf->dirty)
+	    break;
+	if (!wait) {
+	    if (buf != NULL)
+		buf->queue->Prepend(buf);
+	    return NULL;
+	}
+	if (buf == NULL) {		// every buffer is busy
+	    ioDone->Wait(lock);
+	} else if (buf->writing) {	// wait for its write-back
+	    buf->queue->Prepend(buf);
+	    ioDone->Wait(lock);
+	} else {			// write it back
+	    buf->busy = TRUE;
+	    lock->Release();
+	    disk->WriteRaw(buf->sector, buf->data);
+	    lock->Acquire();
+	    buf->busy = buf->dirty = FALSE;
+	    buf->queue->Prepend(buf);	// clean, and still least recent
+	    ioDone->Broadcast(lock);
+	}
+	if ((other = Lookup(sector)) != NULL)
+	    return other;		// someone brought it in meanwhile
+    }
+
+    // Forget the sector's ghost before evicting anything, since that may
+    // push the ghost off the end of its list.
+    if (!prefetch)
+	numMisses++;
+    if ((wasGhost = ((ghost = GhostLookup(sector)) != NULL)))
+	GhostRemove(ghost);
+    if (buf->sector != -1) {
+	DEBUG('f', "Cache evicting sector %d for %d\n", buf->sector, sector);
+	Evicted(buf);
+	HashRemove(buf);
+	stats->numCacheEvictions++;
+    }
+    buf->sector = sector;
+    buf->prefetched = prefetch;
+    buf->busy = TRUE;
+    HashInsert(buf);
+    Admit(buf, wasGhost);
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Ready
+// 	A buffer we claimed has been filled: put it on its list, and let 
+//	anyone waiting for it have it.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Ready(CacheBuffer *buf)
+{
+    buf->busy = FALSE;
+    buf->queue->Append(buf);
+    ioDone->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Fill
+// 	Give a sector that is not in the cache a buffer (see Claim), and 
+//	fill it.
+//
+//	"sector" is the sector that needs a buffer.
+//	"read" is TRUE if the buffer must be filled from disk; FALSE if 
+//		the caller is about to overwrite all of it.
+//	"prefetch" is TRUE if the sector is being read ahead.
+// Returns:
+//	The buffer now holding "sector", on one of the lists (or pinned,
+//	if someone else brought it in and pinned it).
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Fill(int sector, bool read, bool prefetch)
+{
+    CacheBuffer *buf = Claim(sector, prefetch, TRUE);
+
+    if (!buf->busy)
+	return buf;			// someone brought it in meanwhile
+    if (read) {
+	lock->Release();
+	disk->ReadRaw(sector, buf->data);
+	lock->Acquire();
+    }
+    Ready(buf);
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadIn
+// 	Read a sector that is not in the cache, along with as many of the
+//	sectors after it as are not cached either, up to "numSectors" in 
+//	all -- so long as buffers for them can be had without waiting.
+//	They are read from disk with one request (or one per track).
+//
+//	"sector" is the first sector.
+//	"numSectors" is the most sectors to read.
+//	"prefetch" is TRUE if they are being read ahead.
+//	"data" is where to copy them, or NULL.
+// Returns:
+//	The number of sectors read; 0 if someone else brought "sector" in
+//	while we waited for a buffer.
+//----------------------------------------------------------------------
+
+int
+BufferCache::ReadIn(int sector, int numSectors, bool prefetch, char *data)
+{
+    CacheBuffer *run[MaxReadRun];
+    char *where[MaxReadRun];
+    CacheBuffer *buf = Claim(sector, prefetch, TRUE);
+    int n = 0;
+
+    if (!buf->busy)
+	return 0;			// someone brought it in meanwhile
+    do {
+	run[n] = buf;
+	where[n++] = buf->data;
+    } while (n < numSectors && n < MaxReadRun && Find(sector + n) == NULL
+	     && (buf = Claim(sector + n, prefetch, FALSE)) != NULL);
+
+    lock->Release();
+    disk->ReadRaw(sector, where, n);
+    lock->Acquire();
+
+    for (int i = 0; i < n; i++) {
+	if (data != NULL)
+	    bcopy(run[i]->data, &data[i * SectorSize], SectorSize);
+	Ready(run[i]);
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Read, BufferCache::ReadRun
+// 	Copy the contents of a sector, or of a run of consecutive sectors,
+//	into "data", from the cache if they are there, or else reading 
+//	them into the cache first.  Consecutive misses are read from disk
+//	together.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Read(int sector, char *data)
+{
+    ReadRun(sector, 1, data);
+}
+
+void
+BufferCache::ReadRun(int sector, int numSectors, char *data)
+{
+    CacheBuffer *buf;
+    int i = 0, n;
+
+    lock->Acquire();
+    while (i < numSectors) {
+	buf = Lookup(sector + i);
+	if (buf != NULL) {
+	    DEBUG('f', "Cache hit for sector %d\n", sector + i);
+	    stats->numCacheHits++;
+	    Touch(buf);
+	    bcopy(buf->data, &data[i * SectorSize], SectorSize);
+	    i++;
+	} else {
+	    n = ReadIn(sector + i, numSectors - i, FALSE, 
+		       &data[i * SectorSize]);
+	    if (n > 0)
+		DEBUG('f', "Cache miss for sectors %d to %d\n", sector + i, 
+		      sector + i + n - 1);
+	    stats->numCacheMisses += n;
+	    i += n;
+	}
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Write
+// 	Copy "data" into the cache's copy of a sector, and mark it dirty.
+//	On a miss there is no need to read the sector first, since all of
+//	it is overwritten.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Write(int sector, char *data)
+{
+    CacheBuffer *buf;
+
+    lock->Acquire();
+    buf = Lookup(sector);
+    if (buf != NULL) {
+	DEBUG('f', "Cache hit for sector %d\n", sector);
+	stats->numCacheHits++;
+	Touch(buf);
+    } else {
+	DEBUG('f', "Cache miss for sector %d\n", sector);
+	stats->numCacheMisses++;
+	buf = Fill(sector, FALSE);
+    }
+    bcopy(data, buf->data, SectorSize);
+    if (!buf->dirty) {
+	buf->dirty = TRUE;
+	buf->dirtySince = stats->totalTicks;
+	dirtied->Signal(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Pin
+// 	Read a sector into the cache, if it is not there already, and keep
+//	it there until it is unpinned.  Pins do not nest.  At most half the
+//	cache may be pinned.
+//
+// Returns:
+//	FALSE if the sector could not be pinned, because too much of the 
+//	cache is pinned already.
+//----------------------------------------------------------------------
+
+bool
+BufferCache::Pin(int sector)
+{
+    CacheBuffer *buf;
+
+    lock->Acquire();
+    buf = Lookup(sector);
+    if (buf == NULL || !buf->pinned) {
+	if (2 * (numPinned + 1) > numBuffers) {
+	    DEBUG('f', "Cache cannot pin sector %d\n", sector);
+	    lock->Release();
+	    return FALSE;
+	}
+	if (buf == NULL)
+	    buf = Fill(sector, TRUE);
+	if (!buf->pinned) {		// not pinned by someone else
+	    buf->queue->Remove(buf);	// while Fill waited
+	    buf->pinned = TRUE;
+	    numPinned++;
+	    DEBUG('f', "Cache pinned sector %d\n", sector);
+	}
+    }
+    lock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Unpin
+// 	Let a pinned sector be evicted again.  It goes on the most recently
+//	used end of the list of sectors used more than once.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Unpin(int sector)
+{
+    CacheBuffer *buf;
+
+    lock->Acquire();
+    buf = Lookup(sector);
+    if (buf != NULL && buf->pinned) {
+	buf->pinned = FALSE;
+	numPinned--;
+	buf->queue = (policy == CacheLRU) ? recent : frequent;
+	buf->queue->Append(buf);
+	DEBUG('f', "Cache unpinned sector %d\n", sector);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::OldestDirty
+// 	Return when the buffer that has been dirty longest, of those that
+//	can be written back now, was dirtied; or -1 if none is dirty.
+//----------------------------------------------------------------------
+
+int
+BufferCache::OldestDirty()
+{
+    int oldest = -1;
+
+    for (int i = 0; i < numBuffers; i++)
+	if (Flushable(&buffers[i]) 
+	    && (oldest == -1 || buffers[i].dirtySince < oldest))
+	    oldest = buffers[i].dirtySince;
+    return oldest;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::CollectExpired
+// 	Find up to FlushBatchSize buffers that are to be written back now:
+//	those that have been dirty for at least flushAge ticks, and any
+//	dirty buffers next to them on disk, or next to those, and so on.
+//	Writing a run of sectors costs little more than writing the first,
+//	so a neighbour might as well go now as later.
+//
+//	Each buffer collected is marked as being written, so that it is
+//	not collected twice.
+//
+//	"batch" is where to put the buffers.
+// Returns:
+//	The number of buffers collected.
+//----------------------------------------------------------------------
+
+int
+BufferCache::CollectExpired(CacheBuffer **batch)
+{
+    int deadline = stats->totalTicks - flushAge;
+    CacheBuffer *buf;
+    int n = 0;
+
+    for (int i = 0; i < numBuffers && n < FlushBatchSize; i++)
+	if (Flushable(&buffers[i]) && buffers[i].dirtySince <= deadline) {
+	    buffers[i].writing = TRUE;
+	    batch[n++] = &buffers[i];
+	}
+    for (int i = 0; i < n; i++)		// n grows as runs are found
+	for (int next = -1; next <= 1; next += 2) {
+	    buf = Find(batch[i]->sector + next);
+	    if (buf != NULL && Flushable(buf) && n < FlushBatchSize) {
+		buf->writing = TRUE;
+		batch[n++] = buf;
+	    }
+	}
+    return n;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::WriteBatch
+// 	Write back a batch of dirty buffers, in order of sector number, so
+//	that the disk head sweeps across the disk once.  Each run of 
+//	consecutive sectors is written with one request.
+//
+//	Each buffer's contents are copied, and the buffer marked clean, 
+//	before the lock is released.  The buffer can be read, and even 
+//	written again, while the copy goes to disk; it is only kept from
+//	being evicted (see Fill).
+//
+//	"batch" is the buffers, each already marked as being written.
+//	"n" is how many there are.
+//----------------------------------------------------------------------
+
+void
+BufferCache::WriteBatch(CacheBuffer **batch, int n)
+{
+    char *copies = new char[n * SectorSize];
+    char *where[FlushBatchSize];
+    CacheBuffer *buf;
+    int i, j;
+
+    for (i = 1; i < n; i++) {		// insertion sort; n is small
+	buf = batch[i];
+	for (j = i; j > 0 && batch[j - 1]->sector > buf->sector; j--)
+	    batch[j] = batch[j - 1];
+	batch[j] = buf;
+    }
+    for (i = 0; i < n; i++) {
+	where[i] = &copies[i * SectorSize];
+	bcopy(batch[i]->data, where[i], SectorSize);
+	batch[i]->dirty = FALSE;
+    }
+    DEBUG('f', "Cache writing back %d sectors, %d to %d\n", n, 
+	  batch[0]->sector, batch[n - 1]->sector);
+
+    lock->Release();
+    for (i = 0; i < n; i += j) {
+	for (j = 1; i + j < n && batch[i + j]->sector == batch[i]->sector + j;
+	     j++)
+	    ;				// a run of consecutive sectors
+	disk->WriteRaw(batch[i]->sector, &where[i], j);
+    }
+    lock->Acquire();
+
+    for (i = 0; i < n; i++) {
+	batch[i]->writing = FALSE;
+	if (batch[i]->dirty)		// written again meanwhile
+	    dirtied->Signal(lock);
+    }
+    ioDone->Broadcast(lock);
+    delete [] copies;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Flusher
+// 	Forever: wait until some buffer has been dirty for flushAge ticks,
+//	then write it back, along with the others that are due and their
+//	dirty neighbours.  While no buffer is dirty, the flusher waits on
+//	a condition rather than a timer, so that an idle machine can still
+//	halt.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Flusher()
+{
+    CacheBuffer *batch[FlushBatchSize];
+    int oldest;
+
+    lock->Acquire();
+    for (;;) {
+	oldest = OldestDirty();
+	if (oldest == -1) {
+	    dirtied->Wait(lock);
+	} else if (stats->totalTicks < oldest + flushAge) {
+	    lock->Release();
+	    alarmClock->WaitUntil(oldest + flushAge);
+	    lock->Acquire();
+	} else
+	    WriteBatch(batch, CollectExpired(batch));
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadAhead
+// 	Queue some sectors to be read into the cache by the read-ahead 
+//	thread, and return without waiting for them.  Sectors already in
+//	the cache are left out, and so are any that do not fit on the 
+//	queue; they will just be read on demand.
+//
+//	"sectors" is the sectors, in the order they will be wanted.
+//	"numSectors" is how many there are.
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReadAhead(int *sectors, int numSectors)
+{
+    lock->Acquire();
+    for (int i = 0; i < numSectors; i++) {
+	if (readAheadCount == ReadAheadQueueSize)
+	    break;
+	if (Find(sectors[i]) != NULL)
+	    continue;
+	readAheadQueue[(readAheadHead + readAheadCount++) 
+		       % ReadAheadQueueSize] = sectors[i];
+    }
+    if (readAheadCount > 0)
+	readAheadWanted->Signal(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Prefetcher
+// 	Forever: take the next sector off the read-ahead queue, and read 
+//	it in, unless someone has done so meanwhile -- along with the 
+//	consecutive sectors queued after it.  While the queue is
+//	empty, wait on a condition, so that an idle machine can halt.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Prefetcher()
+{
+    int sector, n;
+
+    lock->Acquire();
+    for (;;) {
+	while (readAheadCount == 0)
+	    readAheadWanted->Wait(lock);
+	sector = readAheadQueue[readAheadHead];
+	for (n = 1; n < readAheadCount && readAheadQueue[(readAheadHead + n) 
+				% ReadAheadQueueSize] == sector + n; n++)
+	    ;				// a run of consecutive sectors
+	n = (Find(sector) == NULL) ? ReadIn(sector, n, TRUE, NULL) : 0;
+	if (n > 0) {
+	    DEBUG('f', "Cache read ahead sectors %d to %d\n", sector, 
+		  sector + n - 1);
+	    stats->numReadAheads += n;
+	}
+	n = max(n, 1);			// only we take sectors off the queue
+	readAheadHead = (readAheadHead + n) % ReadAheadQueueSize;
+	readAheadCount -= n;
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Sync
+// 	Write back the dirty buffers holding a set of sectors, in batches
+//	sorted by sector, and return once they are all on disk -- 
+//	including any that someone else was already writing back.
+//
+//	"sectors" is the set of sectors; NULL means every sector.
+//	"numSectors" is how many there are.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Sync(int *sectors, int numSectors)
+{
+    CacheBuffer *batch[FlushBatchSize];
+    CacheBuffer *buf;
+    bool pending;
+    int n;
+
+    if (sectors == NULL)
+	numSectors = numBuffers;
+    lock->Acquire();
+    for (;;) {
+	n = 0;
+	pending = FALSE;
+	for (int i = 0; i < numSectors; i++) {
+	    buf = (sectors == NULL) ? &buffers[i] : Find(sectors[i]);
+	    if (buf == NULL)
+		continue;
+	    if (Flushable(buf) && n < FlushBatchSize) {
+		buf->writing = TRUE;
+		batch[n++] = buf;
+	    } else if (buf->dirty || buf->writing)
+		pending = TRUE;
+	}
+	if (n > 0)
+	    WriteBatch(batch, n);
+	else if (pending)
+	    ioDone->Wait(lock);
+	else
+	    break;
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Flush
+// 	The machine is halting: write every dirty buffer straight to the
+//	disk file.  Nothing can wait for a disk interrupt now, nor for the
+//	lock.  A buffer the flusher was writing back is written again, 
+//	since the flusher may not have got to it.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Flush()
+{
+    CacheBuffer *buf;
+
+    for (int i = 0; i < numBuffers; i++) {
+	buf = &buffers[i];
+	if (buf->sector != -1 && (buf->dirty || buf->writing)) {
+	    disk->WriteNow(buf->sector, buf->data);
+	    buf->dirty = FALSE;
+	}
+    }
+}
@@ -0,0 +1,236 @@
+// bufcache.h 
+//	Data structures for the disk buffer cache: copies of recently used
+//	disk sectors, kept in memory so that most reads and writes do not
+//	have to wait for the disk.
+//
+//	The cache has a fixed number of buffers, chosen when Nachos starts
+//	(see "-cs").  A hash table maps a sector to the buffer holding it,
+//	and the buffers are kept on lists in order of use, least recently
+//	used first, so that both finding a sector and choosing a buffer to
+//	evict take constant time.  Writes only change the buffer.
+//
+//	A dirty buffer is written back to disk by a flusher thread once it
+//	has been dirty for a while (see "-fa"), so that a miss seldom has
+//	to wait for a dirty victim to be written first.  The flusher sorts
+//	what it writes by sector, and takes along any dirty neighbours of 
+//	the buffers that are due, so that runs of sectors are written 
+//	together.  Sync writes back everything at once, or just a given 
+//	set of sectors; and when Nachos halts, whatever is still dirty is 
+//	written straight to the disk file.
+//
+//	A reader that is streaming through a file can ask for the sectors
+//	it is about to need to be read ahead (see OpenFile::ReadAhead).
+//	They go on a queue, and a read-ahead thread reads them in, one at
+//	a time, while the reader is still busy with the sectors before.
+//	A sector read ahead goes on A1in or T1 like any other, and its
+//	first use counts as its first.
+//
+//	Consecutive sectors that are missing are read from the disk with 
+//	one request, as are sectors read ahead together; and so are 
+//	consecutive dirty sectors written back together.
+//
+//	Which buffer to evict is up to the replacement policy (see "-cr"):
+//
+//	   LRU -- the least recently used buffer.  One scan of a large
+//		file evicts everything else.
+//	   2Q -- sectors used once wait on a FIFO queue ("A1in"), which
+//		is limited to a quarter of the cache once the main LRU
+//		list ("Am") fills up.  A sector is promoted to Am if it
+//		is used again, either while on A1in or after it has been
+//		evicted from there, while its number is still remembered
+//		on a "ghost" queue ("A1out").  (After Johnson and Shasha,
+//		VLDB '94; cf. BufferCache::Touch.)
+//	   ARC -- lists of sectors used once ("T1") and more than once 
+//		("T2"), each with a ghost list of sectors recently evicted
+//		from it ("B1", "B2").  A miss that hits a ghost list moves 
+//		the target size of T1 towards the list that would have 
+//		kept the sector.  (Megiddo and Modha, FAST '03.)
+//
+//	Both 2Q and ARC keep a sequential scan from flushing out the
+//	sectors that are used over and over.  Using a sector again before
+//	any other sector has been read in does not count as another use.
+//	Sectors that must never be evicted, such as the file system's own
+//	metadata, can also be pinned in the cache.
+//
+//	One lock protects the whole cache, and is held once per lookup.
+//	It is dropped while a buffer's disk I/O is in progress; the buffer
+//	is marked busy meanwhile, and anyone else who wants it waits.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BUFCACHE_H
+#define BUFCACHE_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "ilist.h"
+#include "synch.h"
+
+class SynchDisk;
+
+#define DefaultFlushAge		20000	// ticks a buffer may stay dirty,
+					// unless "-fa" says otherwise
+#define FlushBatchSize		32	// most sectors written back at once
+#define ReadAheadQueueSize	32	// most sectors waiting to be read 
+					// ahead; any more are dropped
+#define MaxReadRun		16	// most sectors read in at once
+
+// Replacement policies.
+
+enum CachePolicy { CacheLRU, Cache2Q, CacheARC };
+
+extern CachePolicy CachePolicyNamed(char *name);
+					// "lru", "2q" or "arc"
+extern char *CachePolicyName(CachePolicy policy);
+
+// The following class defines one buffer of the cache.
+
+class CacheBuffer {
+  public:
+    int sector;				// sector held, or -1 if none
+    bool dirty;				// changed since read from disk?
+    int dirtySince;			// when it was last clean
+    bool writing;			// being written back by Sync or the
+					// flusher; may not be evicted
+    bool busy;				// disk I/O in progress; not on
+					// any list meanwhile
+    bool pinned;			// never evicted; not on any list
+    bool prefetched;			// read ahead, and not used since
+    IntrusiveList<CacheBuffer> *queue;	// which list we belong on
+    int lastMiss;			// the cache's miss count when we
+					// were last used
+    CacheBuffer *hashNext;		// next buffer on the hash chain
+    IntrusiveLink<CacheBuffer> link;	// our place on that list
+    char data[SectorSize];		// contents of the sector
+};
+
+// The following class defines a ghost: the number of a sector that was
+// recently evicted, without its contents.
+
+class CacheGhost {
+  public:
+    int sector;				// sector remembered, or -1 if none
+    CacheGhost *hashNext;		// next ghost on the hash chain
+    IntrusiveLink<CacheGhost> link;	// our place on a ghost list
+};
+
+// The following class defines the buffer cache of one disk.
+
+class BufferCache {
+  public:
+    BufferCache(SynchDisk *cachedDisk, int cacheSize, 
+		CachePolicy cachePolicy = CacheLRU, int maxDirtyAge = 0);
+					// initialize an empty cache of
+					// "cacheSize" sectors, and start
+					// the flusher unless "maxDirtyAge" 
+					// is 0
+    ~BufferCache();			// de-allocate the cache; does not
+					// write back dirty buffers
+
+    void Read(int sector, char *data);	// copy out a sector, reading it
+					// from disk on a miss
+    void ReadRun(int sector, int numSectors, char *data);
+					// copy out consecutive sectors, 
+					// reading runs of misses at once
+    void Write(int sector, char *data);	// copy in a sector, marking it 
+					// dirty
+
+    bool Pin(int sector);		// read a sector in, and keep it;
+					// FALSE if too much is pinned
+    void Unpin(int sector);		// let it be evicted again
+
+    void Sync(int *sectors = NULL, int numSectors = 0);
+					// write back the dirty buffers of
+					// "sectors" (all of them, if NULL),
+					// and wait until they are on disk
+    void Flush();			// the machine is halting: write 
+					// dirty buffers without waiting
+    void Flusher();			// body of the flusher thread
+
+    void ReadAhead(int *sectors, int numSectors);
+					// start reading in sectors that 
+					// will be wanted soon; do not wait
+    void Prefetcher();			// body of the read-ahead thread
+
+  private:
+    SynchDisk *disk;			// where the sectors come from
+    CachePolicy policy;
+    int numBuffers;
+    int numPinned;
+    int numMisses;			// buffers filled on demand so far
+    int flushAge;			// ticks before the flusher writes 
+					// a dirty buffer; 0 if no flusher
+    CacheBuffer *buffers;		// all of the buffers
+    CacheBuffer **hash;			// hash chains, by sector
+    int hashMask;			// # of chains - 1 (a power of two
+					// - 1)
+    CacheGhost *ghosts;			// all of the ghosts
+    CacheGhost **ghostHash;		// their hash chains, by sector
+
+    // Lists of buffers that are not busy or pinned, and of ghosts, 
+    // each least recently used first.
+    IntrusiveList<CacheBuffer> *unused;	// buffers holding no sector yet
+    IntrusiveList<CacheBuffer> *recent;	// LRU: every buffer; 2Q: A1in; 
+					// ARC: T1
+    IntrusiveList<CacheBuffer> *frequent;	// 2Q: Am; ARC: T2
+    IntrusiveList<CacheGhost> *ghostRecent;	// 2Q: A1out; ARC: B1
+    IntrusiveList<CacheGhost> *ghostFrequent;	// ARC: B2
+    IntrusiveList<CacheGhost> *freeGhosts;
+    int target;				// ARC: target size of T1
+
+    Lock *lock;				// mutual exclusion for all of the 
+					// above
+    Condition *ioDone;			// signalled when a busy buffer's
+					// I/O completes, or a write-back
+    Condition *dirtied;			// signalled when a clean buffer is
+					// written to, for the flusher
+    int *readAheadQueue;		// sectors to be read ahead, a ring
+    int readAheadHead;			// of ReadAheadQueueSize; the first
+    int readAheadCount;			// one, and how many there are
+    Condition *readAheadWanted;		// signalled when sectors are queued
+
+    CacheBuffer *Lookup(int sector);	// the buffer holding sector, once
+					// it is not busy, or NULL
+    CacheBuffer *Fill(int sector, bool read, bool prefetch = FALSE);
+					// evict a buffer, and give it to
+					// "sector"
+    CacheBuffer *Claim(int sector, bool prefetch, bool wait);
+					// ... but leave it busy, to be filled
+    void Ready(CacheBuffer *buf);	// a claimed buffer has been filled
+    int ReadIn(int sector, int numSectors, bool prefetch, char *data);
+					// claim and fill a run of sectors
+    CacheBuffer *Find(int sector);	// the buffer holding sector, busy
+					// or not, or NULL
+    void HashInsert(CacheBuffer *buf);
+    void HashRemove(CacheBuffer *buf);
+    void Touch(CacheBuffer *buf);	// buffer was just used
+
+    // Writing back dirty buffers
+    bool Flushable(CacheBuffer *buf) 
+	{ return buf->dirty && !buf->busy && !buf->writing; }
+    int OldestDirty();			// when the longest-dirty buffer 
+					// was dirtied, or -1 if none
+    int CollectExpired(CacheBuffer **batch);
+					// buffers that have been dirty for
+					// flushAge ticks, and neighbours
+    void WriteBatch(CacheBuffer **batch, int n);
+					// write them back, in sector order
+
+    // The replacement policy
+    int Capacity() { return numBuffers - numPinned; }
+    IntrusiveList<CacheGhost> *Adapt(int sector);
+					// on a miss, before choosing a victim
+    CacheBuffer *ChooseVictim(IntrusiveList<CacheGhost> *ghostList);
+    void Evicted(CacheBuffer *buf);	// remember buf's sector as a ghost
+    void Admit(CacheBuffer *buf, bool wasGhost);
+					// put a newly filled buffer on
+					// the right list
+
+    CacheGhost *GhostLookup(int sector);
+    void GhostAdd(int sector, IntrusiveList<CacheGhost> *ghostList);
+    void GhostRemove(CacheGhost *ghost);
+};
+
+#endif // BUFCACHE_H
@@ -25,6 +25,8 @@
 #include "filehdr.h"
 #include "directory.h"
 
+SLAB_ALLOCATED(Directory)		// see slab.h
+
 //----------------------------------------------------------------------
 // Directory::Directory
 // 	Initialize a directory; initially, the directory is completely
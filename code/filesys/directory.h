@@ -13,6 +13,7 @@
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
+#include "slab.h"
 
 #ifndef DIRECTORY_H
 #define DIRECTORY_H
@@ -50,6 +51,9 @@ class DirectoryEntry {
 // from/to disk. 
 class Directory {
   public:
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *object);	// see slab.h
+
     Directory(int size); 		// Initialize an empty directory
 					// with space for "size" files
     ~Directory();			// De-allocate the directory
@@ -27,6 +27,9 @@
 #include "system.h"
 #include "filehdr.h"
 #include "time.h"
+
+SLAB_ALLOCATED(FileHeader)		// see slab.h
+
 //----------------------------------------------------------------------
 // FileHeader::Allocate
 // 	Initialize a fresh file header for a newly created file.
@@ -226,6 +229,32 @@ FileHeader::ByteToSector(int offset)
 	}
 }
 
+//----------------------------------------------------------------------
+// FileHeader::ListSectors
+// 	Put the numbers of the sectors holding the file's data, and its
+//	second-level index blocks, into "sectors", which must have room
+//	for MaxFileSectors of them.  Return how many there are.
+//----------------------------------------------------------------------
+
+int
+FileHeader::ListSectors(int *sectors)
+{
+    int *index = new int[SecondDirect];
+    int n = 0;
+
+    for (int i = 0; i < numSectors && i < NumDirect; i++)
+	sectors[n++] = dataSectors[i];
+    for (int i = 0, left = numSectors - NumDirect; left > 0; 
+	 i++, left -= SecondDirect) {
+	sectors[n++] = dataSectors[NumDirect + i];
+	synchDisk->ReadSector(dataSectors[NumDirect + i], (char *) index);
+	for (int j = 0; j < left && j < (int) SecondDirect; j++)
+	    sectors[n++] = index[j];
+    }
+    delete [] index;
+    return n;
+}
+
 //----------------------------------------------------------------------
 // FileHeader::FileLength
 // 	Return the number of bytes in the file.
@@ -10,6 +10,7 @@
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
+#include "slab.h"
 
 #ifndef FILEHDR_H
 #define FILEHDR_H
@@ -23,6 +24,9 @@
 #define NumDirect 	((SectorSize - FCBEntrySize-NumSecondIndex * sizeof(int)) / sizeof(int))
 #define NumIndirect	(NumSecondIndex * SectorSize /sizeof(int))
 #define MaxFileSize 	(NumDirect * SectorSize+ NumIndirect * SectorSize)
+#define MaxFileSectors	(NumDirect + NumIndirect + NumSecondIndex)
+					// data and index sectors of the 
+					// largest file
 
 // The following class defines the Nachos "file header" (in UNIX terms,  
 // the "i-node"), describing where on disk to find all of the data in the file.
@@ -41,6 +45,9 @@
 
 class FileHeader {
   public:
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *object);	// see slab.h
+
     bool Allocate(BitMap *bitMap, int fileSize);// Initialize a file header, 
 						//  including allocating space 
 						//  on disk for the file data
@@ -58,6 +65,9 @@ class FileHeader {
     int FileLength();			// Return the length of the file 
 					// in bytes
 
+    int ListSectors(int *sectors);	// List the sectors holding the
+					// file's data and index blocks
+
     void Print();			// Print the contents of the file.
 
     char create_time[25];		// The time created
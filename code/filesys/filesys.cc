@@ -10,16 +10,20 @@
 //	   An entry in the file system directory
 //
 // 	The file system consists of several data structures:
+//	   A superblock, saying how big the volume is and what it is
+//	     made of (cf. synchdisk.h)
 //	   A bitmap of free disk sectors (cf. bitmap.h)
 //	   A directory of file names and file headers
 //
-//      Both the bitmap and the directory are represented as normal
-//	files.  Their file headers are located in specific sectors
-//	(sector 0 and sector 1), so that the file system can find them 
-//	on bootup.
+//	The superblock is in sector 0.  The bitmap takes up as many 
+//	sectors as it needs, however big the disk, from sector 2 on; it
+//	is read into memory when the file system starts up, and only the
+//	sectors of it that change are written back.  The directory is 
+//	represented as a normal file, whose file header is in sector 1, 
+//	so that the file system can find it on bootup.
 //
-//	The file system assumes that the bitmap and directory files are
-//	kept "open" continuously while Nachos is running.
+//	The file system assumes that the directory file is kept "open" 
+//	continuously while Nachos is running.
 //
 //	For those operations (such as Create, Remove) that modify the
 //	directory and/or bitmap, if the operation succeeds, the changes
@@ -52,79 +56,130 @@
 #include "filesys.h"
 #include "system.h"
 
-// Sectors containing the file headers for the bitmap of free sectors,
-// and the directory of files.  These file headers are placed in well-known 
-// sectors, so that they can be located on boot-up.
-#define FreeMapSector 		0
+// Sectors containing the superblock, the file header for the directory
+// of files, and the first of the bitmap of free sectors.  These are 
+// placed in well-known sectors, so that they can be located on boot-up.
+#define SuperblockSector	0
 #define DirectorySector 	1
+#define FreeMapSector 		2
 
-// Initial file sizes for the bitmap and directory; until the file system
-// supports extensible files, the directory size sets the maximum number 
-// of files that can be loaded onto the disk.
-#define FreeMapFileSize 	(NumSectors / BitsInByte)
+// Initial file size for the directory; until the file system supports
+// extensible files, the directory size sets the maximum number of files
+// that can be loaded onto the disk.
 #define NumDirEntries 		10
 #define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
 
+// The following class defines the superblock.  It says how the volume 
+// was formatted, so that it is not mounted with another layout, which
+// would scramble its sectors.
+#define SuperblockMagic		0x2b6f5a11
+
+class Superblock {
+  public:
+    int magic;				// SuperblockMagic
+    int numSectors;			// sectors in the volume
+    int numDisks;			// disks it is made of,
+    int layout;				// and how (a VolumeLayout)
+};
+
+//----------------------------------------------------------------------
+// PinFile
+// 	Pin a file's header and data sectors in the disk buffer cache.
+//	Every Create, Open and Remove reads the root directory, so a scan
+//	of some large file should not evict it.
+//
+//	"sector" -- the sector holding the file's header
+//----------------------------------------------------------------------
+static void
+PinFile(int sector)
+{
+    FileHeader *hdr = new FileHeader;
+
+    if (!synchDisk->Pin(sector))
+	return;				// no cache, or not enough of one
+    hdr->FetchFrom(sector);
+    for (int offset = 0; offset < hdr->FileLength(); offset += SectorSize)
+	if (!synchDisk->Pin(hdr->ByteToSector(offset)))
+	    break;
+    delete hdr;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
 // 	Initialize the file system.  If format = TRUE, the disk has
 //	nothing on it, and we need to initialize the disk to contain
-//	an empty directory, and a bitmap of free sectors (with almost but
-//	not all of the sectors marked as free).  
+//	a superblock, an empty directory, and a bitmap of free sectors 
+//	(with almost but not all of the sectors marked as free).  
 //
-//	If format = FALSE, we just have to open the files
-//	representing the bitmap and the directory.
+//	If format = FALSE, we just have to check the superblock against
+//	the volume, read in the bitmap, and open the file representing 
+//	the directory.
+//
+//	Either way, the directory file is then pinned in the buffer cache.
 //
 //	"format" -- should we initialize the disk?
 //----------------------------------------------------------------------
 FileSystem::FileSystem(bool format)
 { 
+    Superblock *super = new Superblock;
+    char *buffer = new char[SectorSize];
+
     DEBUG('f', "Initializing the file system.\n");
     if (format) {
-        BitMap *freeMap = new BitMap(NumSectors);
+	numSectors = synchDisk->NumSectors();
+	freeMapSectors = divRoundUp(numSectors, SectorSize * BitsInByte);
+	freeMapImage = new char[freeMapSectors * SectorSize];
+        BitMap *freeMap = new BitMap(numSectors);
         Directory *directory = new Directory(NumDirEntries);
-	FileHeader *mapHdr = new FileHeader;
 	FileHeader *dirHdr = new FileHeader;
 
         DEBUG('f', "Formatting the file system.\n");
 
-    // First, allocate space for FileHeaders for the directory and bitmap
-    // (make sure no one else grabs these!)
-	freeMap->Mark(FreeMapSector);	    
+    // First, allocate the superblock, the bitmap, and the FileHeader for 
+    // the directory (make sure no one else grabs these!)
+	freeMap->Mark(SuperblockSector);	    
 	freeMap->Mark(DirectorySector);
+	for (int i = 0; i < freeMapSectors; i++)
+	    freeMap->Mark(FreeMapSector + i);
 
     // Second, allocate space for the data blocks containing the contents
-    // of the directory and bitmap files.  There better be enough space!
+    // of the directory file.  There better be enough space!
 
-	ASSERT(mapHdr->Allocate(freeMap, FreeMapFileSize));
 	ASSERT(dirHdr->Allocate(freeMap, DirectoryFileSize));
-	mapHdr->set_create_time();
 	dirHdr->set_create_time();
 
-    // Flush the bitmap and directory FileHeaders back to disk
-    // We need to do this before we can "Open" the file, since open
+    // Write the superblock, and flush the directory FileHeader back to 
+    // disk.  We need to do this before we can "Open" the file, since open
     // reads the file header off of disk (and currently the disk has garbage
     // on it!).
 
-        DEBUG('f', "Writing headers back to disk.\n");
-	mapHdr->WriteBack(FreeMapSector);    
+        DEBUG('f', "Writing superblock and header back to disk.\n");
+	memset(buffer, 0, SectorSize);
+	super->magic = SuperblockMagic;
+	super->numSectors = numSectors;
+	super->numDisks = synchDisk->NumDisks();
+	super->layout = synchDisk->Layout();
+	bcopy((char *) super, buffer, sizeof(Superblock));
+	synchDisk->WriteSector(SuperblockSector, buffer);
 	dirHdr->WriteBack(DirectorySector);
 
-    // OK to open the bitmap and directory files now
-    // The file system operations assume these two files are left open
-    // while Nachos is running.
+    // OK to open the directory file now
+    // The file system operations assume it is left open while Nachos is 
+    // running.
 
-        freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
      
-    // Once we have the files "open", we can write the initial version
-    // of each file back to disk.  The directory at this point is completely
-    // empty; but the bitmap has been changed to reflect the fact that
-    // sectors on the disk have been allocated for the file headers and
-    // to hold the file data for the directory and bitmap.
+    // Once we have the file "open", we can write the initial version
+    // of the directory back to disk, and all of the bitmap.  The 
+    // directory at this point is completely empty; but the bitmap has 
+    // been changed to reflect the fact that sectors on the disk have 
+    // been allocated for the superblock, the bitmap itself, and the 
+    // directory.
 
         DEBUG('f', "Writing bitmap and directory back to disk.\n");
-	freeMap->WriteBack(freeMapFile);	 // flush changes to disk
+	memset(freeMapImage, 0, freeMapSectors * SectorSize);
+	freeMap->CopyTo(freeMapImage);
+	synchDisk->WriteSectors(FreeMapSector, freeMapSectors, freeMapImage);
 	directory->WriteBack(directoryFile);
 
 	if (DebugIsEnabled('f')) {
@@ -133,15 +188,96 @@ FileSystem::FileSystem(bool format)
 
         delete freeMap; 
 	delete directory; 
-	delete mapHdr; 
 	delete dirHdr;
 	}
     } else {
-    // if we are not formatting the disk, just open the files representing
-    // the bitmap and directory; these are left open while Nachos is running
-        freeMapFile = new OpenFile(FreeMapSector);
+    // if we are not formatting the disk, check that the volume is the one
+    // that was formatted, read in the bitmap, and open the file 
+    // representing the directory; it is left open while Nachos is running
+	synchDisk->ReadSector(SuperblockSector, buffer);
+	bcopy(buffer, (char *) super, sizeof(Superblock));
+	CheckVolume(super);
+	numSectors = super->numSectors;
+	freeMapSectors = divRoundUp(numSectors, SectorSize * BitsInByte);
+	freeMapImage = new char[freeMapSectors * SectorSize];
+	synchDisk->ReadSectors(FreeMapSector, freeMapSectors, freeMapImage);
         directoryFile = new OpenFile(DirectorySector);
     }
+    DEBUG('f', "The file system has %d sectors, %d of them for its bitmap.\n",
+	  numSectors, freeMapSectors);
+    PinFile(DirectorySector);
+    delete super;
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CheckVolume
+// 	Make sure that the volume we are about to mount is the one the
+//	file system was formatted on -- the same number of disks, put 
+//	together the same way (see "-dv"), with the same geometry.
+//
+//	"super" -- the superblock, as read from the volume
+//----------------------------------------------------------------------
+
+void
+FileSystem::CheckVolume(Superblock *super)
+{
+    if (super->magic != SuperblockMagic) {
+	printf("The disk has no file system on it: format it with -f\n");
+	ASSERT(FALSE);
+    }
+    if (super->numDisks != synchDisk->NumDisks()
+	|| (super->numDisks > 1 && super->layout != synchDisk->Layout())) {
+	printf("The file system was formatted on %d disk(s), %s, "
+	       "not %d, %s: give the same -dv as for -f\n", super->numDisks,
+	       VolumeLayoutName((VolumeLayout) super->layout),
+	       synchDisk->NumDisks(), VolumeLayoutName(synchDisk->Layout()));
+	ASSERT(FALSE);
+    }
+    ASSERT(super->numSectors == synchDisk->NumSectors());
+}
+
+//----------------------------------------------------------------------
+// FileSystem::FetchFreeMap
+// 	Return a copy of the bitmap of free sectors, for an operation to
+//	change.  If the operation fails, it just deletes the copy; if it
+//	succeeds, it writes the copy back with WriteBackFreeMap.
+//----------------------------------------------------------------------
+
+BitMap *
+FileSystem::FetchFreeMap()
+{
+    BitMap *freeMap = new BitMap(numSectors);
+
+    freeMap->CopyFrom(freeMapImage);
+    return freeMap;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::WriteBackFreeMap
+// 	Make a changed copy of the bitmap of free sectors the current 
+//	one, writing back to disk those of its sectors that differ.  
+//	Allocating or freeing a few sectors only writes one or two.
+//
+//	"freeMap" -- the changed copy
+//----------------------------------------------------------------------
+
+void
+FileSystem::WriteBackFreeMap(BitMap *freeMap)
+{
+    char *changed = new char[freeMapSectors * SectorSize];
+
+    memset(changed, 0, freeMapSectors * SectorSize);
+    freeMap->CopyTo(changed);
+    for (int i = 0; i < freeMapSectors; i++) {
+	char *was = &freeMapImage[i * SectorSize];
+
+	if (memcmp(was, &changed[i * SectorSize], SectorSize) != 0) {
+	    bcopy(&changed[i * SectorSize], was, SectorSize);
+	    synchDisk->WriteSector(FreeMapSector + i, was);
+	}
+    }
+    delete [] changed;
 }
 
 //----------------------------------------------------------------------
@@ -205,9 +341,8 @@ FileSystem::Create(char *name, int initialSize)
 		success = FALSE;			// file is already in directory
 	}
 	else {	
-		freeMap = new BitMap(NumSectors);
 		DEBUG('f',"fetching bitmap\n");
-		freeMap->FetchFrom(freeMapFile);
+		freeMap = FetchFreeMap();
 		sector = freeMap->Find();	// find a sector to hold the file header
 		DEBUG('f',"%s 's fileheader's sector number is %d \n",name,sector);
 		if (sector == -1) 		
@@ -231,7 +366,7 @@ FileSystem::Create(char *name, int initialSize)
 			// everthing worked, flush all changes back to disk
 			hdr->WriteBack(sector); 		
 			parent->WriteBack(parentFile);
-			freeMap->WriteBack(freeMapFile);
+			WriteBackFreeMap(freeMap);
 			}
 			delete hdr;
 		}
@@ -352,15 +487,14 @@ FileSystem::Remove(char *name)
 	fileHdr = new FileHeader;
 	fileHdr->FetchFrom(sector);
 
-	freeMap = new BitMap(NumSectors);
-	freeMap->FetchFrom(freeMapFile);
+	freeMap = FetchFreeMap();
 	DEBUG('f',"Deallocating file %s's file header\n");
 	fileHdr->Deallocate(freeMap);  		// remove data blocks
 	freeMap->Clear(sector);			// remove header block
 	DEBUG('f',"Remove file %s from its parent dir\n");
 	directory->Remove(name);
 
-	freeMap->WriteBack(freeMapFile);		// flush to disk
+	WriteBackFreeMap(freeMap);		// flush to disk
 	DEBUG('f',"Write Back freemap success\n");
 	directory->WriteBack(parentFile);        // flush to disk
 	DEBUG('f',"Write Back parentFile success\n");
@@ -401,26 +535,24 @@ FileSystem::List()
 void
 FileSystem::Print()
 {
-    FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    BitMap *freeMap = new BitMap(NumSectors);
+    BitMap *freeMap = FetchFreeMap();
     Directory *directory = new Directory(NumDirEntries);
 
-    printf("Bit map file header:\n");
-    bitHdr->FetchFrom(FreeMapSector);
-    bitHdr->Print();
+    printf("Volume of %d sectors, on %d disk(s), %s; bit map in sectors "
+	   "%d to %d\n", numSectors, synchDisk->NumDisks(),
+	   VolumeLayoutName(synchDisk->Layout()), FreeMapSector,
+	   FreeMapSector + freeMapSectors - 1);
 
     printf("Directory file header:\n");
     dirHdr->FetchFrom(DirectorySector);
     dirHdr->Print();
 
-    freeMap->FetchFrom(freeMapFile);
     freeMap->Print();
 
     directory->FetchFrom(directoryFile);
     directory->Print();
 
-    delete bitHdr;
     delete dirHdr;
     delete freeMap;
     delete directory;
@@ -465,11 +597,10 @@ int FileSystem::GetParentSector(char* name){
 }
 
 bool FileSystem::ExtendWrapper(int newNumBytes,int headerSector,FileHeader* f,int sectorNum){
-	BitMap* freeMap=new BitMap(NumSectors);
-	freeMap->FetchFrom(freeMapFile);
+	BitMap* freeMap=FetchFreeMap();
 	if(f->extendLength(newNumBytes,sectorNum,freeMap)){
 		f->WriteBack(headerSector);
-		freeMap->WriteBack(freeMapFile);
+		WriteBackFreeMap(freeMap);
 		delete freeMap;
 		return true;
 	}
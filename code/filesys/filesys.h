@@ -24,9 +24,12 @@
 //	all of the files in the file system; unlike UNIX, the baseline
 //	system does not provide a hierarchical directory structure.  
 //	In addition, there is a bitmap for allocating
-//	disk sectors.  Both the root directory and the bitmap are themselves
-//	stored as files in the Nachos file system -- this causes an interesting
-//	bootstrap problem when the simulated disk is initialized. 
+//	disk sectors.  The root directory is itself stored as a file in 
+//	the Nachos file system -- this causes an interesting bootstrap 
+//	problem when the simulated disk is initialized.  The bitmap has a
+//	bit for every sector of the disk, however big, so it is kept in
+//	a run of sectors of its own, after a superblock that says how
+//	the volume was formatted.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -65,6 +68,9 @@ class FileSystem {
 };
 
 #else // FILESYS
+class BitMap;
+class Superblock;
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -92,10 +98,19 @@ class FileSystem {
     bool ExtendWrapper(int newNumBytes,int headerSector,FileHeader* f,int sectorNum );
 
   private:
-   OpenFile* freeMapFile;		// Bit map of free disk blocks,
-					// represented as a file
+   char *freeMapImage;			// Bit map of free disk blocks, as it
+					// is on disk
+   int freeMapSectors;			// how many sectors it takes up
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a file
+   int numSectors;			// how many sectors the bitmap covers
+
+   void CheckVolume(Superblock *super);	// is this the volume the file 
+					// system was formatted on?
+   BitMap *FetchFreeMap();		// a copy of the bitmap, to change
+   void WriteBackFreeMap(BitMap *freeMap);
+					// make the copy current, writing 
+					// the sectors that changed to disk
 };
 
 #endif // FILESYS
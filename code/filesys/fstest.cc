@@ -7,6 +7,8 @@
 //	   Perftest -- a stress test for the Nachos file system
 //		read and write a really large file in tiny chunks
 //		(won't work on baseline system!)
+//	   CacheBenchmark -- hit rates of the disk buffer cache, for
+//		small files read over and over between scans of a big one
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -183,6 +185,112 @@ PerformanceTest()
     }
     stats->Print();
 }
+
+//----------------------------------------------------------------------
+// CacheBenchmark
+// 	Measure how well the buffer cache's replacement policy (-cr) keeps
+//	sectors that are used over and over, while a large file is being
+//	scanned.  Each round opens and reads a few small files several
+//	times -- metadata-heavy work, like a shell's -- and then reads a
+//	file a few times the size of the cache from start to finish.  The
+//	hit rates of the two phases are printed separately.
+//
+//	Implemented as:
+//	  BenchFill -- create a file and write it
+//	  BenchRead -- read all of a file, a sector at a time
+//	  CacheBenchmark -- overall control, and print out hit rates
+//
+//	filesys/test/cachebench runs it once under each policy.
+//----------------------------------------------------------------------
+
+#define BenchRounds	4
+#define BenchPasses	3		// reads of the small files per round
+#define NumSmallFiles	6
+#define SmallFileSize	(3 * SectorSize)
+#define ScanFileName	"/ScanFile"
+#define ScanFileSize	(160 * SectorSize)
+
+static bool
+BenchFill(char *name, int size)
+{
+    OpenFile *openFile;
+    char buffer[SectorSize];
+
+    if (!fileSystem->Create(name, size)
+	|| (openFile = fileSystem->Open(name)) == NULL) {
+	printf("Cache benchmark: can't create %s\n", name);
+	return FALSE;
+    }
+    memset(buffer, name[1], SectorSize);
+    for (int i = 0; i < size; i += SectorSize)
+	openFile->Write(buffer, SectorSize);
+    delete openFile;
+    return TRUE;
+}
+
+static void
+BenchRead(char *name)
+{
+    OpenFile *openFile;
+    char buffer[SectorSize];
+
+    if ((openFile = fileSystem->Open(name)) == NULL) {
+	printf("Cache benchmark: unable to open %s\n", name);
+	return;
+    }
+    while (openFile->Read(buffer, SectorSize) > 0)
+	;
+    delete openFile;
+}
+
+static void
+PrintHitRate(char *what, int hits, int misses)
+{
+    printf("%s: %d hits, %d misses, hit rate %d%%\n", what, hits, misses,
+	(hits + misses > 0) ? (100 * hits) / (hits + misses) : 0);
+}
+
+void
+CacheBenchmark()
+{
+    char names[NumSmallFiles][16];
+    int metaHits = 0, metaMisses = 0, scanHits = 0, scanMisses = 0;
+    int hits, misses;
+
+    printf("Starting buffer cache benchmark:\n");
+    for (int i = 0; i < NumSmallFiles; i++) {
+	sprintf(names[i], "/Small%d", i);
+	if (!BenchFill(names[i], SmallFileSize))
+	    return;
+    }
+    if (!BenchFill(ScanFileName, ScanFileSize))
+	return;
+
+    for (int round = 0; round < BenchRounds; round++) {
+	hits = stats->numCacheHits;
+	misses = stats->numCacheMisses;
+	for (int pass = 0; pass < BenchPasses; pass++)
+	    for (int i = 0; i < NumSmallFiles; i++)
+		BenchRead(names[i]);
+	metaHits += stats->numCacheHits - hits;
+	metaMisses += stats->numCacheMisses - misses;
+
+	hits = stats->numCacheHits;
+	misses = stats->numCacheMisses;
+	BenchRead(ScanFileName);
+	scanHits += stats->numCacheHits - hits;
+	scanMisses += stats->numCacheMisses - misses;
+    }
+
+    PrintHitRate("Small files", metaHits, metaMisses);
+    PrintHitRate("Scans", scanHits, scanMisses);
+    PrintHitRate("Total", metaHits + scanHits, metaMisses + scanMisses);
+
+    for (int i = 0; i < NumSmallFiles; i++)
+	fileSystem->Remove(names[i]);
+    fileSystem->Remove(ScanFileName);
+}
+
 void ex4_test(){
     if (!fileSystem->Create("/testdir", -1)) {
 	    DEBUG('f',"can't create directory\n");
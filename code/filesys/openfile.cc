@@ -19,6 +19,8 @@
 #include <strings.h>
 #endif
 
+SLAB_ALLOCATED(OpenFile)		// see slab.h
+
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
 // 	Open a Nachos file for reading and writing.  Bring the file header
@@ -35,6 +37,9 @@ OpenFile::OpenFile(int sector)
     //hdr->Print();
     seekPosition = 0;
     headerSector=sector;
+    lastRead = -1;
+    readAhead = 0;
+    readAheadEnd = 0;
 }
 
 //----------------------------------------------------------------------
@@ -91,6 +96,78 @@ OpenFile::Write(char *into, int numBytes)
    return result;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::ReadAhead
+// 	Called by ReadAt, before it reads sectors "first" through "last"
+//	of the file.  If the file is being read sequentially, ask the 
+//	buffer cache to start reading the sectors after "last", so that 
+//	the disk is busy with them while the caller is busy with these.
+//
+//	The window of sectors read ahead starts at MinReadAhead, and 
+//	doubles, up to MaxReadAhead, each time a read moves on to sectors
+//	that were read ahead.  A read anywhere else is a seek: it closes
+//	the window, until reads look sequential again.
+//
+//	"fileLength" is the length of the file in bytes.
+//----------------------------------------------------------------------
+
+void
+OpenFile::ReadAhead(int first, int last, int fileLength)
+{
+    int sectors[MaxReadAhead];
+    int fileSectors = divRoundUp(fileLength, SectorSize);
+    int i, end, n = 0;
+
+    if (first != lastRead && first != lastRead + 1) {	// a seek
+	DEBUG('f', "Seek to sector %d of file %d, no read-ahead\n", first, 
+	      headerSector);
+	readAhead = 0;
+	readAheadEnd = last + 1;
+	lastRead = last;
+	return;
+    }
+    if (last <= lastRead)		// still in the same sector
+	return;
+    if (readAhead == 0)
+	readAhead = MinReadAhead;
+    else if (last < readAheadEnd && readAhead < MaxReadAhead)
+	readAhead *= 2;			// read ahead in time: do more
+    lastRead = last;
+
+    end = min(last + 1 + readAhead, fileSectors);
+    for (i = max(readAheadEnd, last + 1); i < end; i++)
+	sectors[n++] = hdr->ByteToSector(i * SectorSize);
+    if (end > readAheadEnd)
+	readAheadEnd = end;
+    if (n > 0) {
+	DEBUG('f', "Reading ahead %d sectors of file %d, window %d\n", n, 
+	      headerSector, readAhead);
+	synchDisk->ReadAhead(sectors, n);
+    }
+}
+
+//----------------------------------------------------------------------
+// OpenFile::SectorRun
+// 	Find the disk sector holding sector "first" of the file, and how 
+//	many of the file's sectors from there up to "last" follow it on 
+//	disk, so that they can be transferred together.  Files allocated
+//	with FindN are usually one run.
+//
+//	"sector" is where to put the first disk sector.
+//----------------------------------------------------------------------
+
+int
+OpenFile::SectorRun(int first, int last, int *sector)
+{
+    int n = 1;
+
+    *sector = hdr->ByteToSector(first * SectorSize);
+    while (first + n <= last 
+	   && hdr->ByteToSector((first + n) * SectorSize) == *sector + n)
+	n++;
+    return n;
+}
+
 //----------------------------------------------------------------------
 // OpenFile::ReadAt/WriteAt
 // 	Read/write a portion of a file, starting at "position".
@@ -110,6 +187,9 @@ OpenFile::Write(char *into, int numBytes)
 //	   in the data that will be modified, and write back all the full
 //	   or partial sectors that are part of the request.
 //
+//	Either way, sectors that are consecutive on disk are transferred 
+//	as one run (see SectorRun).
+//
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
 //	"numBytes" -- the number of bytes to transfer
@@ -120,7 +200,7 @@ int
 OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
+    int i, firstSector, lastSector, numSectors, sector, run;
     char *buf;
 
     if ((numBytes <= 0) || (position >= fileLength))
@@ -136,10 +216,13 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
 
     // read in all the full and partial sectors that we need
 	synchDisk->StartRead(this->headerSector);
+    ReadAhead(firstSector, lastSector, fileLength);
     buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
+    for (i = firstSector; i <= lastSector; i += run) {
+	run = SectorRun(i, lastSector, &sector);
+        synchDisk->ReadSectors(sector, run, 
 					&buf[(i - firstSector) * SectorSize]);
+    }
     synchDisk->EndRead(this->headerSector);
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
@@ -154,7 +237,7 @@ int
 OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
+    int i, firstSector, lastSector, numSectors, sector, run;
     bool firstAligned, lastAligned;
     char *buf;
 
@@ -197,9 +280,11 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
 
 	synchDisk->StartWrite(this->headerSector);
 // write modified sectors back
-    for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
+    for (i = firstSector; i <= lastSector; i += run) {
+	run = SectorRun(i, lastSector, &sector);
+        synchDisk->WriteSectors(sector, run, 
 					&buf[(i - firstSector) * SectorSize]);
+    }
     synchDisk->EndWrite(this->headerSector);
 
     hdr->set_visit_time();
@@ -209,6 +294,24 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     return numBytes;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::Sync
+// 	Write the file's header, index blocks and data back to disk, if
+//	the buffer cache holds changes to them, and return once they are
+//	there.
+//----------------------------------------------------------------------
+
+void
+OpenFile::Sync()
+{
+    int *sectors = new int[MaxFileSectors + 1];
+    int numSectors = hdr->ListSectors(sectors);
+
+    sectors[numSectors++] = headerSector;
+    synchDisk->Sync(sectors, numSectors);
+    delete [] sectors;
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Length
 // 	Return the number of bytes in the file.
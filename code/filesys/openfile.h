@@ -22,6 +22,8 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "slab.h"
+#include "aio.h"
 
 #ifdef FILESYS_STUB			// Temporarily implement calls to 
 					// Nachos file system as calls to UNIX!
@@ -52,6 +54,16 @@ class OpenFile {
 		}
 
     int Length() { Lseek(file, 0, 2); return Tell(file); }
+    void Sync() { }			// nothing cached here; UNIX has it
+
+    AioRequest *ReadAtAsync(char *into, int numBytes, int position,
+			    VoidFunctionPtr callWhenDone = NULL, 
+			    int callArg = 0);
+    AioRequest *WriteAtAsync(char *from, int numBytes, int position,
+			     VoidFunctionPtr callWhenDone = NULL, 
+			     int callArg = 0);
+					// Start a ReadAt/WriteAt, and return
+					// at once (see aio.h)
     
   private:
     int file;
@@ -61,8 +73,15 @@ class OpenFile {
 #else // FILESYS
 class FileHeader;
 
+#define MinReadAhead	2		// sectors read ahead once a file
+					// is being read sequentially
+#define MaxReadAhead	16		// most sectors read ahead
+
 class OpenFile {
   public:
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *object);	// see slab.h
+
     OpenFile(int sector);		// Open a file whose header is located
 					// at "sector" on the disk
     ~OpenFile();			// Close the file
@@ -81,15 +100,40 @@ class OpenFile {
 					// bypassing the implicit position.
     int WriteAt(char *from, int numBytes, int position);
 
+    AioRequest *ReadAtAsync(char *into, int numBytes, int position,
+			    VoidFunctionPtr callWhenDone = NULL, 
+			    int callArg = 0);
+    AioRequest *WriteAtAsync(char *from, int numBytes, int position,
+			     VoidFunctionPtr callWhenDone = NULL, 
+			     int callArg = 0);
+					// Start a ReadAt/WriteAt, and return
+					// at once; wait for the request
+					// to finish, then delete it
+
     int Length(); 			// Return the number of bytes in the
 					// file (this interface is simpler 
 					// than the UNIX idiom -- lseek to 
 					// end of file, tell, lseek back 
+
+    void Sync();			// Write any cached changes to the
+					// file back to disk -- UNIX fsync
     
   private:
     FileHeader *hdr;			// Header for this file 
     int seekPosition;			// Current position within the file
     int headerSector;			// sector number for the file's file header
+
+    // Sequential read-ahead
+    int lastRead;			// last sector of the file read, or -1
+    int readAhead;			// how many sectors to read ahead;
+					// 0 until reads look sequential
+    int readAheadEnd;			// first sector not yet read ahead
+    void ReadAhead(int first, int last, int fileLength);
+					// about to read sectors "first" 
+					// through "last" of the file
+    int SectorRun(int first, int last, int *sector);
+					// how many of those are consecutive 
+					// on disk, starting at "*sector"
 };
 
 #endif // FILESYS
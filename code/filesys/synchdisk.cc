@@ -5,10 +5,16 @@
 //	the disk providing a synchronous interface (requests wait until
 //	the request completes).
 //
-//	Use a semaphore to synchronize the interrupt handlers with the
-//	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	Each request carries a semaphore, to synchronize the interrupt
+//	handler with the thread waiting for it.  And, because the physical
+//	disk can only handle one operation at a time, requests that arrive
+//	while it is busy are queued, and the interrupt handler starts the
+//	next one as each finishes.  A volume of several disks has a queue
+//	per disk, and all of them may be busy at once.
+//
+//	The disk also keeps track of which files are open, and lets many
+//	read a file but only one write it; what it knows about each file
+//	in use is in a small hash table.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,8 +22,9 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "slab.h"
 #include "system.h"
-#define CacheEnabled
+
 //----------------------------------------------------------------------
 // DiskRequestDone
 // 	Disk interrupt handler.  Need this to be a C routine, because 
@@ -26,9 +33,59 @@
 static void
 DiskRequestDone (int arg)
 {
-    SynchDisk* disk = (SynchDisk *)arg;
+    Spindle* spindle = (Spindle *)arg;
+
+    spindle->volume->RequestDone(spindle);
+}
+
+//----------------------------------------------------------------------
+// DiskScheduleNamed, DiskScheduleName
+// 	Convert between a disk scheduling policy and its name on the 
+//	command line.
+//----------------------------------------------------------------------
+
+static char *scheduleNames[] = { "fcfs", "sstf", "clook" };
+
+DiskSchedule
+DiskScheduleNamed(char *name)
+{
+    for (int i = DiskFCFS; i <= DiskCLOOK; i++)
+	if (!strcmp(name, scheduleNames[i]))
+	    return (DiskSchedule) i;
+    printf("Unknown disk scheduling policy %s: use fcfs, sstf or clook\n", 
+	   name);
+    ASSERT(FALSE);
+    return DiskCLOOK;
+}
 
-    disk->RequestDone();
+char *
+DiskScheduleName(DiskSchedule schedule)
+{
+    return scheduleNames[schedule];
+}
+
+//----------------------------------------------------------------------
+// VolumeLayoutNamed, VolumeLayoutName
+// 	Convert between a volume layout and its name on the command line.
+//----------------------------------------------------------------------
+
+static char *layoutNames[] = { "stripe", "mirror" };
+
+VolumeLayout
+VolumeLayoutNamed(char *name)
+{
+    for (int i = VolumeStripe; i <= VolumeMirror; i++)
+	if (!strcmp(name, layoutNames[i]))
+	    return (VolumeLayout) i;
+    printf("Unknown volume layout %s: use stripe or mirror\n", name);
+    ASSERT(FALSE);
+    return VolumeStripe;
+}
+
+char *
+VolumeLayoutName(VolumeLayout layout)
+{
+    return layoutNames[layout];
 }
 
 //----------------------------------------------------------------------
@@ -37,27 +94,62 @@ DiskRequestDone (int arg)
 //	initializing the physical disk.
 //
 //	"name" -- UNIX file name to be used as storage for the disk data
-//	   (usually, "DISK")
+//	   (usually, "DISK"); the other disks of a volume add 1, 2, ...
+//	   to it
+//	"cacheSectors" -- the size of the buffer cache; 0 for none
+//	"cachePolicy" -- how the buffer cache chooses what to evict
+//	"flushAge" -- how long a cached sector may stay dirty; 0 to write 
+//	   it back only when it is evicted or synced
+//	"requestOrder" -- the order in which to serve queued requests
+//	"mapped" -- map the UNIX file into memory (see disk.h)
+//	"tracks", "trackSectors" -- the geometry to format the disks
+//	   with, or 0 to keep the one they have
+//	"disks" -- how many disks make up the volume
+//	"volumeLayout" -- how the volume's sectors are spread over them
 //----------------------------------------------------------------------
-SynchDisk::SynchDisk(char* name)
+SynchDisk::SynchDisk(char* name, int cacheSectors, CachePolicy cachePolicy,
+		     int flushAge, DiskSchedule requestOrder, bool mapped,
+		     int tracks, int trackSectors, int disks,
+		     VolumeLayout volumeLayout)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
-    disk = new Disk(name, DiskRequestDone, (int) this);
-    readerCnt=new int[NumSectors];
-    openerCnt=new int[NumSectors];
-    memset(readerCnt,0,sizeof(int)*NumSectors);
-    memset(openerCnt,0,sizeof(int)*NumSectors);
-   for(int i=0;i<NumSectors;i++){
-	rCntMutex[i]=new Semaphore("reader cnt mutex",1);
-	oCntMutex[i]=new Semaphore("opener cnt mutex",1);
-	RW[i]=new Semaphore("reader writer mutex",1);
-   } 
-   for(int i=0;i<CacheSize;i++){
-	   CacheTable[i]=new CacheEntry();
-	   CacheTable[i]->dirty=CacheTable[i]->valid=false;
-	   CacheTable[i]->lru=stats->totalTicks;
-   }
+    char *diskName = new char[strlen(name) + 10];
+    int perDisk;
+
+    ASSERT(disks >= 1 && disks <= MaxDisks);
+    schedule = requestOrder;
+    numDisks = disks;
+    layout = volumeLayout;
+    spindles = new Spindle[numDisks];
+    for (int i = 0; i < numDisks; i++) {
+	Spindle *spindle = &spindles[i];
+
+	if (i == 0)
+	    strcpy(diskName, name);
+	else
+	    sprintf(diskName, "%s%d", name, i);
+	spindle->volume = this;
+	spindle->queue = new IntrusiveList<DiskRequest>;
+	spindle->active = NULL;
+	spindle->headSector = 0;
+	spindle->disk = new Disk(diskName, DiskRequestDone, (int) spindle, 
+				 mapped, tracks, trackSectors);
+	ASSERT(spindle->disk->NumTracks() == spindles[0].disk->NumTracks());
+	ASSERT(spindle->disk->SectorsPerTrack() 
+	       == spindles[0].disk->SectorsPerTrack());
+    }
+    delete [] diskName;
+
+    perDisk = spindles[0].disk->NumSectors();
+    if (layout == VolumeMirror || numDisks == 1)
+	numSectors = perDisk;
+    else
+	numSectors = (perDisk / StripeSectors) * StripeSectors * numDisks;
+    DEBUG('d', "Volume of %d disks, %s, %d sectors\n", numDisks,
+	  VolumeLayoutName(layout), numSectors);
+    for (int i = 0; i < FileUseBuckets; i++)
+	fileUses[i] = NULL;
+   cache=(cacheSectors>0)?
+	new BufferCache(this,cacheSectors,cachePolicy,flushAge):NULL;
 }
 
 //----------------------------------------------------------------------
@@ -67,19 +159,20 @@ SynchDisk::SynchDisk(char* name)
 //----------------------------------------------------------------------
 SynchDisk::~SynchDisk()
 {
-    delete disk;
-    delete lock;
-    delete semaphore;
-    delete readerCnt;
-    delete openerCnt;
-    for(int i=0;i<NumSectors;i++){
-	    delete rCntMutex[i];
-	    delete oCntMutex[i];
-	    delete RW[i];
-    }
-    for(int i=0;i<CacheSize;i++){
-	    delete CacheTable[i];
+    for (int i = 0; i < numDisks; i++) {
+	delete spindles[i].disk;
+	delete spindles[i].queue;
     }
+    delete [] spindles;
+    for (int i = 0; i < FileUseBuckets; i++)
+	while (fileUses[i] != NULL) {
+	    FileUse *use = fileUses[i];
+
+	    fileUses[i] = use->next;
+	    delete use->lock;
+	    delete use;
+	}
+    delete cache;
 }
 
 //----------------------------------------------------------------------
@@ -93,43 +186,16 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-#ifdef CacheEnabled
-	bool hit=false;
-	for(int i=0;i<CacheSize;i++){
-		lock->Acquire();			// only one disk I/O at a time
-		if(CacheTable[i]->valid&&CacheTable[i]->sector==sectorNumber){
-			DEBUG('f',"Cache hit for sector %2d\n",sectorNumber);
-			memcpy(data,&(CacheTable[i]->data[0]),SectorSize);
-			hit=true;
-			CacheTable[i]->lru=stats->totalTicks;
-		}
-		lock->Release();
-	}
-	if(!hit){
-		CacheMiss(sectorNumber);
-		for(int i=0;i<CacheSize;i++){
-			lock->Acquire();			// only one disk I/O at a time
-			if(CacheTable[i]->valid&&CacheTable[i]->sector==sectorNumber){
-				DEBUG('f',"Cache hit for sector %2d\n",sectorNumber);
-				memcpy(data,&(CacheTable[i]->data[0]),SectorSize);
-				hit=true;
-				CacheTable[i]->lru=stats->totalTicks;
-			}
-			lock->Release();
-		}
-	}
-#else
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
-#endif
+    if (cache != NULL)
+	cache->Read(sectorNumber, data);
+    else
+	ReadRaw(sectorNumber, data);
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::WriteSector
 // 	Write the contents of a buffer into a disk sector.  Return only
-//	after the data has been written.
+//	after the data has been written (to the cache, if there is one).
 //
 //	"sectorNumber" -- the disk sector to be written
 //	"data" -- the new contents of the disk sector
@@ -137,126 +203,496 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-#ifdef CacheEnabled
-	bool hit=false;
-	for(int i=0;i<CacheSize;i++){
-		lock->Acquire();			// only one disk I/O at a time
-		if(CacheTable[i]->valid&&CacheTable[i]->sector==sectorNumber){
-			DEBUG('f',"Cache hit for sector %2d\n",sectorNumber);
-			memcpy(&(CacheTable[i]->data[0]),data,SectorSize);
-			hit=true;
-			CacheTable[i]->lru=stats->totalTicks;
-			CacheTable[i]->dirty=true;
-		}
-		lock->Release();
+    if (cache != NULL)
+	cache->Write(sectorNumber, data);
+    else
+	WriteRaw(sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors
+// 	Read a run of consecutive disk sectors into a buffer.  Through the
+//	cache, the sectors it does not hold are read a run at a time; 
+//	without one, the whole run is read straight from the disk.
+//
+//	"sectorNumber" -- the first disk sector to read
+//	"count" -- how many to read
+//	"data" -- the buffer to hold them, count * SectorSize bytes
+//----------------------------------------------------------------------
+void
+SynchDisk::ReadSectors(int sectorNumber, int count, char* data)
+{
+    char **buffers;
+
+    if (cache != NULL) {
+	cache->ReadRun(sectorNumber, count, data);
+	return;
+    }
+    buffers = new char *[count];
+    for (int i = 0; i < count; i++)
+	buffers[i] = &data[i * SectorSize];
+    ReadRaw(sectorNumber, buffers, count);
+    delete [] buffers;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	Write a buffer into a run of consecutive disk sectors.  The cache 
+//	only needs to copy each one; without one, the whole run is written
+//	straight to the disk.
+//----------------------------------------------------------------------
+void
+SynchDisk::WriteSectors(int sectorNumber, int count, char* data)
+{
+    char **buffers;
+
+    if (cache != NULL) {
+	for (int i = 0; i < count; i++)
+	    cache->Write(sectorNumber + i, &data[i * SectorSize]);
+	return;
+    }
+    buffers = new char *[count];
+    for (int i = 0; i < count; i++)
+	buffers[i] = &data[i * SectorSize];
+    WriteRaw(sectorNumber, buffers, count);
+    delete [] buffers;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadRaw
+// 	Read a disk sector, or a run of them, straight from the disk.  
+//	Return only after the data has been read.  A run is read with one
+//	disk request per track (and stripe) it covers.
+//----------------------------------------------------------------------
+void
+SynchDisk::ReadRaw(int sectorNumber, char* data)
+{
+    Transfer(sectorNumber, &data, 1, FALSE);
+}
+
+void
+SynchDisk::ReadRaw(int sectorNumber, char** data, int count)
+{
+    Transfer(sectorNumber, data, count, FALSE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteRaw
+// 	Write a disk sector, or a run of them, straight to the disk.  
+//	Return only after the data has been written.
+//----------------------------------------------------------------------
+void
+SynchDisk::WriteRaw(int sectorNumber, char* data)
+{
+    Transfer(sectorNumber, &data, 1, TRUE);
+}
+
+void
+SynchDisk::WriteRaw(int sectorNumber, char** data, int count)
+{
+    Transfer(sectorNumber, data, count, TRUE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Locate
+// 	Return where sector "sectorNumber" of the volume is on its disk,
+//	and set "which" to the disk (for a mirror, any of them) and 
+//	"runLength" to how many sectors from there on are next to each 
+//	other on the same track of that disk.
+//----------------------------------------------------------------------
+int
+SynchDisk::Locate(int sectorNumber, int *which, int *runLength)
+{
+    int sectorsPerTrack = spindles[0].disk->SectorsPerTrack();
+    int sector = sectorNumber;
+    int left = numSectors - sectorNumber;
+    int stripe;
+
+    ASSERT(sectorNumber >= 0 && sectorNumber < numSectors);
+    *which = 0;
+    if (layout == VolumeStripe && numDisks > 1) {
+	stripe = sectorNumber / StripeSectors;
+	*which = stripe % numDisks;
+	sector = (stripe / numDisks) * StripeSectors 
+			+ sectorNumber % StripeSectors;
+	left = StripeSectors - sectorNumber % StripeSectors;
+    }
+    *runLength = min(left, sectorsPerTrack - sector % sectorsPerTrack);
+    return sector;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ChooseMirror
+// 	Return which disk of a mirror to read "sectorNumber" from: the one
+//	with the fewest requests waiting or being served, and of those, 
+//	the one whose head has the fewest tracks to seek.  Called with 
+//	interrupts off.
+//----------------------------------------------------------------------
+int
+SynchDisk::ChooseMirror(int sectorNumber)
+{
+    int sectorsPerTrack = spindles[0].disk->SectorsPerTrack();
+    int best = 0, bestLoad = 0, bestSeek = 0;
+
+    for (int i = 0; i < numDisks; i++) {
+	Spindle *spindle = &spindles[i];
+	int load = spindle->queue->NumInList() 
+			+ ((spindle->active != NULL) ? 1 : 0);
+	int seek = abs(sectorNumber / sectorsPerTrack 
+		       - spindle->headSector / sectorsPerTrack);
+
+	if (i == 0 || load < bestLoad 
+			|| (load == bestLoad && seek < bestSeek)) {
+	    best = i;
+	    bestLoad = load;
+	    bestSeek = seek;
 	}
-	if(!hit){
-		CacheMiss(sectorNumber);
-		for(int i=0;i<CacheSize;i++){
-			lock->Acquire();			// only one disk I/O at a time
-			if(CacheTable[i]->valid&&CacheTable[i]->sector==sectorNumber){
-				DEBUG('f',"Cache hit for sector %2d\n",sectorNumber);
-				memcpy(&(CacheTable[i]->data[0]),data,SectorSize);
-				hit=true;
-				CacheTable[i]->lru=stats->totalTicks;
-				CacheTable[i]->dirty=true;
-			}
-			lock->Release();
-		}
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Transfer
+// 	Queue requests to read or write a run of sectors, one for each 
+//	piece of the run on one track of one disk (and for a mirrored 
+//	write, one for each disk), start any disk that is idle, and wait 
+//	until the interrupt handlers say they are all done.  The disks
+//	of a volume serve their pieces at the same time.
+//
+//	A long run is done MaxPendingRequests requests at a time.
+//----------------------------------------------------------------------
+void
+SynchDisk::Transfer(int sectorNumber, char** data, int count, 
+		    bool writing)
+{
+    Semaphore done("disk request", 0);
+    DiskRequest requests[MaxPendingRequests];
+    int copies = (layout == VolumeMirror && writing) ? numDisks : 1;
+    int i = 0, n, which, sector, pending;
+    IntStatus oldLevel;
+
+    while (i < count) {
+	oldLevel = interrupt->SetLevel(IntOff);
+	for (pending = 0; i < count 
+			&& pending + copies <= MaxPendingRequests; i += n) {
+	    sector = Locate(sectorNumber + i, &which, &n);
+	    n = min(n, count - i);
+	    for (int c = 0; c < copies; c++) {
+		DiskRequest *request = &requests[pending++];
+
+		request->sector = sector;
+		request->data = &data[i];
+		request->numSectors = n;
+		request->writing = writing;
+		request->done = &done;
+		if (layout == VolumeMirror)
+		    which = writing ? c : ChooseMirror(sector);
+		Submit(&spindles[which], request);
+	    }
 	}
+	(void) interrupt->SetLevel(oldLevel);
+	while (pending-- > 0)
+	    done.P();			// wait for interrupts
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Submit
+// 	Queue a request for one disk, and start it if the disk is idle.
+//	Called with interrupts off.
+//----------------------------------------------------------------------
+void
+SynchDisk::Submit(Spindle *spindle, DiskRequest *request)
+{
+    spindle->queue->Append(request);
+    if (spindle->active == NULL)
+	StartNext(spindle);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ChooseNext
+// 	Return the queued request that the scheduling policy would serve
+//	next, leaving it on the queue.  The queue is short, so we just
+//	look at every request.
+//----------------------------------------------------------------------
+DiskRequest *
+SynchDisk::ChooseNext(Spindle *spindle)
+{
+    IntrusiveList<DiskRequest> *queue = spindle->queue;
+    DiskRequest *req, *best = queue->Front();
+    int sectorsPerTrack = spindle->disk->SectorsPerTrack();
+    int diskSectors = spindle->disk->NumSectors();
+    int headSector = spindle->headSector;
+    int headTrack = headSector / sectorsPerTrack;
+    int dist, bestDist = 0;
+
+    if (schedule == DiskFCFS)
+	return best;
+    for (req = queue->Front(); req != NULL; req = req->link.next) {
+	if (schedule == DiskSSTF)	// tracks to seek, then rotation
+	    dist = abs(req->sector / sectorsPerTrack - headTrack) 
+			* sectorsPerTrack
+		   + (req->sector - headSector - 1 + diskSectors) 
+			% sectorsPerTrack;
+	else				// sweep up, wrapping at the end
+	    dist = (req->sector - headSector + diskSectors) % diskSectors;
+	if (req == queue->Front() || dist < bestDist) {
+	    best = req;
+	    bestDist = dist;
+	}
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartNext
+// 	Take the next request off the queue, and send it to the disk, 
+//	which must be idle.  Called with interrupts off, either by a thread
+//	making a request, or by the interrupt handler.
+//----------------------------------------------------------------------
+void
+SynchDisk::StartNext(Spindle *spindle)
+{
+    DiskRequest *active;
+
+    ASSERT(interrupt->getLevel() == IntOff && spindle->active == NULL);
+    active = spindle->active = ChooseNext(spindle);
+    spindle->queue->Remove(active);
+    DEBUG('d', "Disk %d scheduling sector %d after %d, %d still queued\n", 
+	  (int) (spindle - spindles), active->sector, spindle->headSector, 
+	  spindle->queue->NumInList());
+    spindle->headSector = active->sector + active->numSectors - 1;
+    if (active->writing)
+	spindle->disk->WriteRequest(active->sector, active->data, 
+				    active->numSectors);
+    else
+	spindle->disk->ReadRequest(active->sector, active->data, 
+				   active->numSectors);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteNow
+// 	Write a disk sector straight to the disk file (or for a mirror,
+//	to each of them), without waiting for the disk; for the buffer 
+//	cache, when the machine halts.
+//----------------------------------------------------------------------
+void
+SynchDisk::WriteNow(int sectorNumber, char* data)
+{
+    int which, n;
+    int sector = Locate(sectorNumber, &which, &n);
+
+    for (int i = 0; i < numDisks; i++)
+	if (layout == VolumeMirror || i == which)
+	    spindles[i].disk->WriteNow(sector, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Sync
+// 	Write back the dirty cached copies of some sectors, and return 
+//	once they are on disk.
+//
+//	"sectors" -- the sectors; NULL for every sector in the cache
+//	"count" -- how many there are
+//----------------------------------------------------------------------
+void
+SynchDisk::Sync(int *sectors, int count)
+{
+    if (cache != NULL)
+	cache->Sync(sectors, count);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Flush
+// 	The machine is halting: write every dirty cached sector to the
+//	disk file now.
+//----------------------------------------------------------------------
+void
+SynchDisk::Flush()
+{
+    if (cache != NULL)
+	cache->Flush();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadAhead
+// 	Start reading some sectors into the cache, which a reader is 
+//	expected to want soon, and return at once.  Without a cache, there
+//	is nowhere to put them.
+//----------------------------------------------------------------------
+void
+SynchDisk::ReadAhead(int *sectors, int count)
+{
+    if (cache != NULL)
+	cache->ReadAhead(sectors, count);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Pin, SynchDisk::Unpin
+// 	Keep a sector in the buffer cache, so that reading it never waits
+//	for the disk, or let it be evicted again.
+//----------------------------------------------------------------------
+bool
+SynchDisk::Pin(int sectorNumber)
+{
+    return (cache != NULL) && cache->Pin(sectorNumber);
+}
 
-#else
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
-#endif
+void
+SynchDisk::Unpin(int sectorNumber)
+{
+    if (cache != NULL)
+	cache->Unpin(sectorNumber);
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::RequestDone
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// 	Disk interrupt handler.  Wake up the thread waiting for the disk
+//	request to finish, and start the next one for the same disk, if 
+//	any.
 //----------------------------------------------------------------------
 void
-SynchDisk::RequestDone()
+SynchDisk::RequestDone(Spindle *spindle)
 { 
-    semaphore->V();
+    DiskRequest *request = spindle->active;
+
+    spindle->active = NULL;
+    request->done->V();
+    if (!spindle->queue->IsEmpty())
+	StartNext(spindle);
+}
+
+// A FileUse is made and destroyed every time a file goes from unused to
+// used and back.
+SLAB_ALLOCATED(FileUse)		// see slab.h
+
+//----------------------------------------------------------------------
+// SynchDisk::FindUse
+// 	Return what we know about the file whose header is in "hdrSector";
+//	if nobody is using it, make a new FileUse if "create", or else 
+//	return NULL.  Called with interrupts off.
+//----------------------------------------------------------------------
+FileUse *
+SynchDisk::FindUse(int hdrSector, bool create)
+{
+    FileUse **bucket = &fileUses[hdrSector % FileUseBuckets];
+    FileUse *use;
+
+    for (use = *bucket; use != NULL; use = use->next)
+	if (use->sector == hdrSector)
+	    return use;
+    if (!create)
+	return NULL;
+    use = new FileUse;
+    use->sector = hdrSector;
+    use->openers = 0;
+    use->users = 0;
+    use->lock = new RWLock("file lock");
+    use->next = *bucket;
+    *bucket = use;
+    return use;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::PutUse
+// 	Destroy a FileUse, if the file is no longer open, and nobody is 
+//	reading or writing it.  Called with interrupts off.
+//----------------------------------------------------------------------
+void
+SynchDisk::PutUse(FileUse *use)
+{
+    FileUse **link = &fileUses[use->sector % FileUseBuckets];
+
+    if (use->openers > 0 || use->users > 0)
+	return;
+    while (*link != use)
+	link = &(*link)->next;
+    *link = use->next;
+    delete use->lock;
+    delete use;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartUse, SynchDisk::EndUse
+// 	Count a thread that is about to read or write a file, so that its
+//	FileUse (and lock) stays put until the thread is done with it.
+//----------------------------------------------------------------------
+FileUse *
+SynchDisk::StartUse(int hdrSector)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    FileUse *use = FindUse(hdrSector, TRUE);
+
+    use->users++;
+    (void) interrupt->SetLevel(oldLevel);
+    return use;
+}
+
+void
+SynchDisk::EndUse(FileUse *use)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    use->users--;
+    PutUse(use);
+    (void) interrupt->SetLevel(oldLevel);
 }
 
 void SynchDisk::StartRead(int hdrSector){
 	DEBUG('F',"waiting to read hdrsector=%2d\n",hdrSector);
-	rCntMutex[hdrSector]->P();
-	if(readerCnt[hdrSector]==0)
-		RW[hdrSector]->P();
-	readerCnt[hdrSector]++;
-	rCntMutex[hdrSector]->V();
+	StartUse(hdrSector)->lock->ReadAcquire();
 	DEBUG('F',"permitted to read hdrsector=%2d\n",hdrSector);
 }
 void SynchDisk::EndRead(int hdrSector){
-	rCntMutex[hdrSector]->P();
-	readerCnt[hdrSector]--;
-	if(readerCnt[hdrSector]==0)
-		RW[hdrSector]->V();
-	rCntMutex[hdrSector]->V();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+	FileUse *use = FindUse(hdrSector, FALSE);
+
+	(void) interrupt->SetLevel(oldLevel);
+	use->lock->ReadRelease();
+	EndUse(use);
 	DEBUG('F'," read hdrsector=%2d finished\n",hdrSector);
 
 }
 void SynchDisk::StartWrite(int hdrSector){
 	DEBUG('F',"waiting to write hdrsector=%2d\n",hdrSector);
-	RW[hdrSector]->P();
+	StartUse(hdrSector)->lock->WriteAcquire();
 	DEBUG('F',"premited to write hdrsector=%2d\n",hdrSector);
 }
 void SynchDisk::EndWrite(int hdrSector){
-	RW[hdrSector]->V();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+	FileUse *use = FindUse(hdrSector, FALSE);
+
+	(void) interrupt->SetLevel(oldLevel);
+	use->lock->WriteRelease();
+	EndUse(use);
 	DEBUG('F'," write hdrsector=%2d finished\n",hdrSector);
 }
 void SynchDisk::Open(int hdrSector){
-	oCntMutex[hdrSector]->P();
-	openerCnt[hdrSector]++;
-	oCntMutex[hdrSector]->V();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	FindUse(hdrSector, TRUE)->openers++;
+	(void) interrupt->SetLevel(oldLevel);
 }
 void SynchDisk::Close(int hdrSector){
-	oCntMutex[hdrSector]->P();
-	openerCnt[hdrSector]--;
-	oCntMutex[hdrSector]->V();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+	FileUse *use = FindUse(hdrSector, FALSE);
+
+	use->openers--;
+	PutUse(use);
+	(void) interrupt->SetLevel(oldLevel);
 }
 int SynchDisk::GetOpenStart(int hdrSector){
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+	FileUse *use = FindUse(hdrSector, FALSE);
+	int openers = (use != NULL) ? use->openers : 0;
+
+	(void) interrupt->SetLevel(oldLevel);
 	DEBUG('F',"accessing the openercnt hdrsector:%2d \n",hdrSector);
-	//oCntMutex[hdrSector]->P();
-	DEBUG('f',"Open cnt for %2d is %2d\n",hdrSector,openerCnt[hdrSector]);
-	 return openerCnt[hdrSector];
+	DEBUG('f',"Open cnt for %2d is %2d\n",hdrSector,openers);
+	 return openers;
 }
 int SynchDisk::GetOpenDone(int hdrSector){
 	DEBUG('f',"in get open done\n");
-	//oCntMutex[hdrSector]->V();
 	DEBUG('F',"finished accessing the openercnt hdrsector:%2d \n",hdrSector);
+	return 0;
 }
-void SynchDisk::CacheMiss(int sector){
-	int evict=0;
-	for(int i=0;i<CacheSize;i++){
-		if(!CacheTable[i]->valid){
-			evict=i;
-			break;
-		}
-		if(CacheTable[i]->lru<CacheTable[evict]->lru)
-			evict=i;
-	}
-	if(CacheTable[evict]->valid&&CacheTable[evict]->dirty){
-		lock->Acquire();			// only one disk I/O at a time
-		disk->WriteRequest(CacheTable[evict]->sector, &(CacheTable[evict]->data[0]));
-		semaphore->P();			// wait for interrupt
-		CacheTable[evict]->dirty=false;
-		CacheTable[evict]->valid=false;
-		lock->Release();
-	}
-	//Swap in
-	lock->Acquire();			// only one disk I/O at a time
-	disk->ReadRequest(sector, &(CacheTable[evict]->data[0]));
-	semaphore->P();			// wait for interrupt
-	CacheTable[evict]->dirty=false;
-	CacheTable[evict]->valid=true;
-	CacheTable[evict]->lru=stats->totalTicks;
-	CacheTable[evict]->sector=sector;
-	lock->Release();
-}
\ No newline at end of file
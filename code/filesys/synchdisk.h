@@ -13,15 +13,91 @@
 
 #include "disk.h"
 #include "synch.h"
-#define CacheSize 8
-class CacheEntry{
-	public:
-		bool valid;
-		bool dirty;
-		int sector;
-		int lru;
-		char data[SectorSize];
+#include "ilist.h"
+#include "bufcache.h"
+
+#define DefaultCacheSectors	64	// buffer cache size, unless "-cs"
+					// says otherwise
+
+// Disk scheduling policies: the order in which queued requests are
+// sent to the disk.
+
+enum DiskSchedule { DiskFCFS, DiskSSTF, DiskCLOOK };
+
+extern DiskSchedule DiskScheduleNamed(char *name);
+					// "fcfs", "sstf" or "clook"
+extern char *DiskScheduleName(DiskSchedule schedule);
+
+// Ways to make one volume out of several disks.
+
+enum VolumeLayout { VolumeStripe, VolumeMirror };
+
+extern VolumeLayout VolumeLayoutNamed(char *name);
+					// "stripe" or "mirror"
+extern char *VolumeLayoutName(VolumeLayout layout);
+
+#define MaxDisks		8	// most disks in a volume
+#define StripeSectors		4	// sectors on one disk before a
+					// stripe goes on to the next
+#define MaxPendingRequests	16	// most disk requests a transfer 
+					// has outstanding at once
+
+// The following class defines one request waiting for the disk, or 
+// being served by it.  It lives on the stack of the thread that made
+// it, which sleeps until the request is done.
+
+class DiskRequest {
+  public:
+    int sector;				// (first) sector to read or write
+    char **data;			// where the data comes from or goes,
+					// one buffer per sector
+    int numSectors;			// how many sectors, all on one track
+    bool writing;
+    Semaphore *done;			// V'ed when the disk is finished
+    IntrusiveLink<DiskRequest> link;	// our place on the queue
+};
+
+class SynchDisk;
+
+// The following class defines one disk of a volume, and the requests
+// waiting for it.  Each disk has its own head, and serves its requests 
+// at the same time as the others.
+
+class Spindle {
+  public:
+    SynchDisk *volume;			// the volume the disk is part of
+    Disk *disk;				// raw disk device
+
+    // Shared with the interrupt handler, so only touched with 
+    // interrupts off
+    IntrusiveList<DiskRequest> *queue;	// requests waiting for the disk
+    DiskRequest *active;		// the request the disk is serving,
+					// or NULL if it is idle
+    int headSector;			// where the last request left the
+					// disk head
 };
+
+// The following class defines what is known about one file in use: how
+// many have it open, and who is reading or writing it.  It is made when
+// the file is first opened or used, and destroyed once nobody is using
+// it, so this takes memory in proportion to the files in use, not to 
+// the size of the disk.
+
+class FileUse {
+  public:
+    int sector;				// the file's header sector
+    int openers;			// how many have it open
+    int users;				// how many are reading or writing
+					// it, or waiting to
+    RWLock *lock;			// readers and writers of the file
+    FileUse *next;			// next on the hash chain
+
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *object);	// see slab.h
+};
+
+#define FileUseBuckets	64		// hash chains of FileUses
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -32,11 +108,51 @@ class CacheEntry{
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
 // returning.
+//
+// Many threads may make requests at once.  Those the disk cannot start
+// yet wait on a queue, and each time the disk finishes one, the next is
+// chosen by the scheduling policy (see "-ds"):
+//
+//	FCFS -- in the order they were made.
+//	SSTF -- the one on the track nearest the head; among those on
+//		the same track, the next to rotate under it.
+//	C-LOOK -- the one with the lowest sector number at or beyond the
+//		head; once there are none, the lowest of all.  The head
+//		sweeps up the disk and jumps back, so no request starves.
+//
+// The volume may be made of several disks, each in its own UNIX file
+// (see "-dv"), with the same geometry:
+//
+//	stripe -- (RAID-0) each StripeSectors sectors are on the next
+//		disk, round robin, so a run of sectors is spread over all 
+//		of the disks, and they transfer it together.
+//	mirror -- (RAID-1) every disk holds every sector.  A write goes
+//		to all of them; a read goes to the one with the fewest 
+//		requests waiting, and of those, the one whose head is 
+//		nearest.
+//
+// Each disk has its own queue, and schedules it by the same policy.
+//
+// Sectors are read and written through a buffer cache (see bufcache.h),
+// unless its size is 0.
 class SynchDisk {
   public:
-    SynchDisk(char* name);    		// Initialize a synchronous disk,
-					// by initializing the raw Disk.
+    SynchDisk(char* name, int cacheSectors = DefaultCacheSectors,
+	      CachePolicy cachePolicy = CacheLRU, int flushAge = 0,
+	      DiskSchedule requestOrder = DiskCLOOK, bool mapped = FALSE,
+	      int tracks = 0, int trackSectors = 0, int disks = 1,
+	      VolumeLayout volumeLayout = VolumeStripe);
+					// Initialize a synchronous disk,
+					// by initializing the raw Disks
+					// (with a new geometry, if 
+					// "tracks" is not 0).
     ~SynchDisk();			// De-allocate the synch disk data
+
+    int NumSectors() { return numSectors; }
+					// how big the volume is
+    int NumDisks() { return numDisks; }
+    VolumeLayout Layout() { return layout; }
+					// what it is made of
     
     void ReadSector(int sectorNumber, char* data);
     					// Read/write a disk sector, returning
@@ -45,8 +161,37 @@ class SynchDisk {
     					// Disk::ReadRequest/WriteRequest and
 					// then wait until the request is done.
     void WriteSector(int sectorNumber, char* data);
+    void ReadSectors(int sectorNumber, int count, char* data);
+    void WriteSectors(int sectorNumber, int count, char* data);
+					// Read/write a run of consecutive
+					// sectors, as few disk requests as
+					// possible
+    void ReadRaw(int sectorNumber, char* data);
+    void WriteRaw(int sectorNumber, char* data);
+    void ReadRaw(int sectorNumber, char** data, int count);
+    void WriteRaw(int sectorNumber, char** data, int count);
+					// Read/write a disk sector, or a run
+					// of them, one buffer each, bypassing
+					// the cache -- for the cache itself
+    void WriteNow(int sectorNumber, char* data);
+					// Write a sector without waiting, as
+					// the machine halts
+    bool Pin(int sectorNumber);		// Keep a sector in the cache; FALSE
+					// if it cannot be (or there is no
+					// cache)
+    void Unpin(int sectorNumber);
+
+    void Sync(int *sectors = NULL, int count = 0);
+					// Write back cached sectors (all of
+					// them, if "sectors" is NULL), and
+					// wait until they are on disk
+    void Flush();			// Write back every cached sector as
+					// the machine halts
+    void ReadAhead(int *sectors, int count);
+					// Start reading sectors into the 
+					// cache, without waiting for them
     
-    void RequestDone();			// Called by the disk device interrupt
+    void RequestDone(Spindle *spindle);	// Called by the disk device interrupt
 					// handler, to signal that the
 					// current disk operation is complete.
 	void StartRead(int hdrSector);
@@ -57,20 +202,37 @@ class SynchDisk {
 	void Close(int hdrSector);
 	int GetOpenStart(int hdrSector);
 	int GetOpenDone(int hdrSector);
-	void CacheMiss(int sector);
 
   private:
-    Disk *disk;		  		// Raw disk device
-    Semaphore *semaphore; 		// To synchronize requesting thread 
-					// with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-					// can be sent to the disk at a time
-	int *readerCnt;			
-	int *openerCnt;
-	Semaphore *rCntMutex[NumSectors];
-	Semaphore *oCntMutex[NumSectors];
-	Semaphore *RW[NumSectors];
-	CacheEntry *CacheTable[CacheSize];
+    Spindle *spindles;			// the disks of the volume
+    int numDisks;
+    VolumeLayout layout;		// how sectors are spread over them
+    int numSectors;			// sectors in the volume
+    DiskSchedule schedule;		// which request goes next
+
+    FileUse *fileUses[FileUseBuckets];	// files in use, hashed by header
+					// sector; only touched with 
+					// interrupts off
+	BufferCache *cache;		// recently used sectors, or NULL
+
+    void Transfer(int sectorNumber, char** data, int count, 
+		  bool writing);	// queue requests for a run of 
+					// sectors, and wait for them all
+    int Locate(int sectorNumber, int *which, int *runLength);
+					// where a sector is in the volume,
+					// and how many follow it there
+    int ChooseMirror(int sectorNumber);	// the disk to read a mirrored 
+					// sector from
+    void Submit(Spindle *spindle, DiskRequest *request);
+					// queue a request for one disk
+    void StartNext(Spindle *spindle);	// send the next request to a disk
+    DiskRequest *ChooseNext(Spindle *spindle);
+					// the one the policy picks
+    FileUse *FindUse(int hdrSector, bool create);
+					// the file's FileUse, or NULL
+    void PutUse(FileUse *use);		// destroy it, if no longer in use
+    FileUse *StartUse(int hdrSector);	// count a reader or writer ...
+    void EndUse(FileUse *use);		// ... and stop counting it
 };
 
 #endif // SYNCHDISK_H
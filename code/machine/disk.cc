@@ -19,11 +19,23 @@
 
 // We put this at the front of the UNIX file representing the
 // disk, to make it less likely we will accidentally treat a useful file 
-// as a disk (which would probably trash the file's contents).
-#define MagicNumber 	0x456789ab
-#define MagicSize 	sizeof(int)
+// as a disk (which would probably trash the file's contents).  It also
+// says how the disk was formatted.
+#define MagicNumber 	0x456789ac	// (0x456789ab had no geometry)
 
-#define DiskSize 	(MagicSize + (NumSectors * SectorSize))
+class DiskLabel {
+  public:
+    int magic;				// MagicNumber
+    int sectorSize;			// must be SectorSize
+    int numTracks;
+    int sectorsPerTrack;
+};
+
+#define LabelSize 	((int) sizeof(DiskLabel))
+
+#define DiskSize 	(LabelSize + (numSectors * SectorSize))
+#define MaxDiskSectors	((0x7fffffff - LabelSize) / SectorSize)
+					// file offsets must fit in an int
 
 // dummy procedure because we can't take a pointer of a member function
 static void DiskDone(int arg) { ((Disk *)arg)->HandleInterrupt(); }
@@ -31,18 +43,24 @@ static void DiskDone(int arg) { ((Disk *)arg)->HandleInterrupt(); }
 //----------------------------------------------------------------------
 // Disk::Disk()
 // 	Initialize a simulated disk.  Open the UNIX file (creating it
-//	if it doesn't exist), and check the magic number to make sure it's 
+//	if it doesn't exist), and check the label to make sure it's 
 // 	ok to treat it as Nachos disk storage.
 //
 //	"name" -- text name of the file simulating the Nachos disk
 //	"callWhenDone" -- interrupt handler to be called when disk read/write
 //	   request completes
 //	"callArg" -- argument to pass the interrupt handler
+//	"mapped" -- map the UNIX file into memory, and copy sectors in and
+//	   out of it, rather than reading and writing the file
+//	"tracks", "trackSectors" -- the geometry to give the disk, 
+//	   whatever was there before; or 0, to keep the geometry it has
+//	   (or the default, for a new disk)
 //----------------------------------------------------------------------
 
-Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
+Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg, 
+	   bool mapped, int tracks, int trackSectors)
 {
-    int magicNum;
+    DiskLabel label;
     int tmp = 0;
 
     DEBUG('d', "Initializing the disk, 0x%x 0x%x\n", callWhenDone, callArg);
@@ -52,29 +70,51 @@ Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
     bufferInit = 0;
     
     fileno = OpenForReadWrite(name, FALSE);
-    if (fileno >= 0) {		 	// file exists, check magic number 
-	Read(fileno, (char *) &magicNum, MagicSize);
-	ASSERT(magicNum == MagicNumber);
-    } else {				// file doesn't exist, create it
-        fileno = OpenForWrite(name);
-	magicNum = MagicNumber;  
-	WriteFile(fileno, (char *) &magicNum, MagicSize); // write magic number
-
-	// need to write at end of file, so that reads will not return EOF
-        Lseek(fileno, DiskSize - sizeof(int), 0);	
+    if (fileno >= 0 && tracks == 0) {	// file exists, check label
+	Read(fileno, (char *) &label, LabelSize);
+	ASSERT(label.magic == MagicNumber);
+	ASSERT(label.sectorSize == SectorSize);
+    } else {				// new disk, or new geometry
+	if (fileno < 0)
+	    fileno = OpenForWrite(name);
+	label.magic = MagicNumber;
+	label.sectorSize = SectorSize;
+	label.numTracks = (tracks > 0) ? tracks : DefaultNumTracks;
+	label.sectorsPerTrack = (trackSectors > 0) ? trackSectors 
+						    : DefaultSectorsPerTrack;
+	ASSERT(label.numTracks <= MaxDiskSectors / label.sectorsPerTrack);
+	Lseek(fileno, 0, 0);
+	WriteFile(fileno, (char *) &label, LabelSize);	// write label
+    }
+    numTracks = label.numTracks;
+    sectorsPerTrack = label.sectorsPerTrack;
+    numSectors = label.numTracks * label.sectorsPerTrack;
+    DEBUG('d', "Disk %s has %d tracks of %d sectors\n", name, 
+	  this->numTracks, this->sectorsPerTrack);
+
+    // need to write at end of file, so that reads will not return EOF
+    Lseek(fileno, DiskSize - sizeof(int), 0);	
+    if (ReadPartial(fileno, (char *) &tmp, sizeof(int)) < (int) sizeof(int)) {
+	Lseek(fileno, DiskSize - sizeof(int), 0);	
 	WriteFile(fileno, (char *)&tmp, sizeof(int));  
     }
+    image = mapped ? MapFile(fileno, DiskSize) : NULL;
     active = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Disk::~Disk()
 // 	Clean up disk simulation, by closing the UNIX file representing the
-//	disk.
+//	disk -- once everything written to it in memory is in the file, if
+//	it is mapped.
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
+    if (image != NULL) {
+	SyncMappedFile(image, DiskSize);
+	UnmapFile(image, DiskSize);
+    }
     Close(fileno);
 }
 
@@ -99,7 +139,8 @@ PrintSector (bool writing, int sector, char *data)
 
 //----------------------------------------------------------------------
 // Disk::ReadRequest/WriteRequest
-// 	Simulate a request to read/write a single disk sector
+// 	Simulate a request to read/write a single disk sector, or a run
+//	of sectors on one track
 //	   Do the read/write immediately to the UNIX file
 //	   Set up an interrupt handler to be called later,
 //	      that will notify the caller when the simulator says
@@ -108,50 +149,114 @@ PrintSector (bool writing, int sector, char *data)
 //	Note that a disk only allows an entire sector to be read/written,
 //	not part of a sector.
 //
-//	"sectorNumber" -- the disk sector to read/write
-//	"data" -- the bytes to be written, the buffer to hold the incoming bytes
+//	"sectorNumber" -- the (first) disk sector to read/write
+//	"data" -- the bytes to be written, the buffer to hold the incoming 
+//	   bytes; for a run, one such buffer per sector
+//	"count" -- how many sectors in the run
 //----------------------------------------------------------------------
 
 void
 Disk::ReadRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
+    ReadRequest(sectorNumber, &data, 1);
+}
 
-    ASSERT(!active);				// only one request at a time
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
-    
-    DEBUG('d', "Reading from sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
-    if (DebugIsEnabled('d'))
-	PrintSector(FALSE, sectorNumber, data);
+void
+Disk::WriteRequest(int sectorNumber, char* data)
+{
+    WriteRequest(sectorNumber, &data, 1);
+}
+
+void
+Disk::ReadRequest(int sectorNumber, char** data, int count)
+{
+    int ticks = ComputeLatency(sectorNumber, FALSE, count);
+
+    CheckRequest(sectorNumber, count);
+    DEBUG('d', "Reading from sector %d, %d sectors\n", sectorNumber, 
+	  count);
+    if (image == NULL)
+	Lseek(fileno, SectorSize * sectorNumber + LabelSize, 0);
+    for (int i = 0; i < count; i++) {
+	if (image != NULL)
+	    bcopy(&image[SectorSize * (sectorNumber + i) + LabelSize], 
+		  data[i], SectorSize);
+	else
+	    Read(fileno, data[i], SectorSize);
+	if (DebugIsEnabled('d'))
+	    PrintSector(FALSE, sectorNumber + i, data[i]);
+    }
     
     active = TRUE;
-    UpdateLast(sectorNumber);
+    UpdateLast(sectorNumber + count - 1);
     stats->numDiskReads++;
     interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
 }
 
 void
-Disk::WriteRequest(int sectorNumber, char* data)
+Disk::WriteRequest(int sectorNumber, char** data, int count)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
-
-    ASSERT(!active);
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
-    
-    DEBUG('d', "Writing to sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
-    if (DebugIsEnabled('d'))
-	PrintSector(TRUE, sectorNumber, data);
+    int ticks = ComputeLatency(sectorNumber, TRUE, count);
+
+    CheckRequest(sectorNumber, count);
+    DEBUG('d', "Writing to sector %d, %d sectors\n", sectorNumber, 
+	  count);
+    if (image == NULL)
+	Lseek(fileno, SectorSize * sectorNumber + LabelSize, 0);
+    for (int i = 0; i < count; i++) {
+	if (image != NULL)
+	    bcopy(data[i], &image[SectorSize * (sectorNumber + i) + LabelSize],
+		  SectorSize);
+	else
+	    WriteFile(fileno, data[i], SectorSize);
+	if (DebugIsEnabled('d'))
+	    PrintSector(TRUE, sectorNumber + i, data[i]);
+    }
     
     active = TRUE;
-    UpdateLast(sectorNumber);
+    UpdateLast(sectorNumber + count - 1);
     stats->numDiskWrites++;
     interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
 }
 
+//----------------------------------------------------------------------
+// Disk::CheckRequest()
+// 	Make sure a request can be started: the disk is idle, and the 
+//	sectors exist and are all on one track.
+//----------------------------------------------------------------------
+
+void
+Disk::CheckRequest(int sectorNumber, int count)
+{
+    ASSERT(!active);				// only one request at a time
+    ASSERT((sectorNumber >= 0) && (count > 0) 
+	   && (sectorNumber + count <= numSectors));
+    ASSERT(sectorNumber / sectorsPerTrack 
+	   == (sectorNumber + count - 1) / sectorsPerTrack);
+}
+
+//----------------------------------------------------------------------
+// Disk::WriteNow()
+// 	Write a single disk sector straight to the UNIX file, without
+//	simulating the time it takes, and without an interrupt.  Only for
+//	when the machine is halting, and nobody can wait for a request.
+//----------------------------------------------------------------------
+
+void
+Disk::WriteNow(int sectorNumber, char* data)
+{
+    ASSERT((sectorNumber >= 0) && (sectorNumber < numSectors));
+    
+    DEBUG('d', "Writing to sector %d at halt\n", sectorNumber);
+    if (image != NULL)
+	bcopy(data, &image[SectorSize * sectorNumber + LabelSize], SectorSize);
+    else {
+	Lseek(fileno, SectorSize * sectorNumber + LabelSize, 0);
+	WriteFile(fileno, data, SectorSize);
+    }
+    stats->numDiskWrites++;
+}
+
 //----------------------------------------------------------------------
 // Disk::HandleInterrupt()
 // 	Called when it is time to invoke the disk interrupt handler,
@@ -179,8 +284,8 @@ Disk::HandleInterrupt ()
 int
 Disk::TimeToSeek(int newSector, int *rotation) 
 {
-    int newTrack = newSector / SectorsPerTrack;
-    int oldTrack = lastSector / SectorsPerTrack;
+    int newTrack = newSector / sectorsPerTrack;
+    int oldTrack = lastSector / sectorsPerTrack;
     int seek = abs(newTrack - oldTrack) * SeekTime;
 				// how long will seek take?
     int over = (stats->totalTicks + seek) % RotationTime; 
@@ -202,16 +307,18 @@ Disk::TimeToSeek(int newSector, int *rotation)
 int 
 Disk::ModuloDiff(int to, int from)
 {
-    int toOffset = to % SectorsPerTrack;
-    int fromOffset = from % SectorsPerTrack;
+    int toOffset = to % sectorsPerTrack;
+    int fromOffset = from % sectorsPerTrack;
 
-    return ((toOffset - fromOffset) + SectorsPerTrack) % SectorsPerTrack;
+    return ((toOffset - fromOffset) + sectorsPerTrack) % sectorsPerTrack;
 }
 
 //----------------------------------------------------------------------
 // Disk::ComputeLatency()
-// 	Return how long will it take to read/write a disk sector, from
-//	the current position of the disk head.
+// 	Return how long will it take to read/write a disk sector, or a run
+//	of "count" sectors on its track, from the current position of
+//	the disk head.  Once the first sector of a run has been reached,
+//	each of the rest takes another RotationTime.
 //
 //   	Latency = seek time + rotational latency + transfer time
 //   	Disk seeks at one track per SeekTime ticks (cf. stats.h)
@@ -230,26 +337,36 @@ Disk::ModuloDiff(int to, int from)
 //----------------------------------------------------------------------
 
 int
-Disk::ComputeLatency(int newSector, bool writing)
+Disk::ComputeLatency(int newSector, bool writing, int count)
 {
     int rotation;
     int seek = TimeToSeek(newSector, &rotation);
     int timeAfter = stats->totalTicks + seek + rotation;
+    int transfer = count * RotationTime;
+
+    if (seek > 0) {
+	stats->numDiskSeeks++;
+	stats->diskSeekTicks += seek;
+    }
 
 #ifndef NOTRACKBUF	// turn this on if you don't want the track buffer stuff
     // check if track buffer applies
     if ((writing == FALSE) && (seek == 0) 
 		&& (((timeAfter - bufferInit) / RotationTime) 
 	     		> ModuloDiff(newSector, bufferInit / RotationTime))) {
-        DEBUG('d', "Request latency = %d\n", RotationTime);
-	return RotationTime; // time to transfer sector from the track buffer
+        DEBUG('d', "Request latency = %d\n", transfer);
+	if (tracer != NULL)
+	    tracer->DiskRequest(newSector, writing, 0, 0, transfer);
+	return transfer;     // time to transfer sector from the track buffer
     }
 #endif
 
     rotation += ModuloDiff(newSector, timeAfter / RotationTime) * RotationTime;
 
-    DEBUG('d', "Request latency = %d\n", seek + rotation + RotationTime);
-    return(seek + rotation + RotationTime);
+    DEBUG('d', "Request latency = %d\n", seek + rotation + transfer);
+    if (tracer != NULL)
+	tracer->DiskRequest(newSector, writing, seek, rotation, transfer);
+    return(seek + rotation + transfer);
 }
 
 //----------------------------------------------------------------------
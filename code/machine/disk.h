@@ -26,13 +26,28 @@
 // sector has the same number of bytes of storage).  
 //
 // Addressing is by sector number -- each sector on the disk is given
-// a unique number: track * SectorsPerTrack + offset within a track.
+// a unique number: track * SectorsPerTrack() + offset within a track.
+//
+// How many tracks there are, and how many sectors on each, is chosen
+// when the disk is formatted, and kept in a label at the front of the
+// UNIX file, along with the sector size; a disk opened later takes its
+// geometry from there.  The sector size itself is fixed when Nachos is
+// compiled, since so much depends on it (the page size, and the layout
+// of file headers and directories), so a disk made with another size
+// is refused.  Nothing is kept in memory per sector, and the UNIX file
+// only takes up space for the sectors that have been written, so a disk
+// can be made much bigger than the default -- up to 2GB.  There may be
+// any number of disks, each in its own UNIX file.
 //
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
 // and an interrupt is invoked later to signal that the operation completed.
 //
 // The physical disk is in fact simulated via operations on a UNIX file.
+// Optionally, the file is mapped into memory, and sectors are copied in
+// and out of it with no system call at all; the changes are written back
+// to the file when the disk is deleted.  Either way, the file and the
+// simulated timing are the same.
 //
 // To make life a little more realistic, the simulated time for
 // each operation reflects a "track buffer" -- RAM to store the contents
@@ -45,20 +60,34 @@
 // disks these days now come with a track buffer.
 //
 // The track buffer simulation can be disabled by compiling with -DNOTRACKBUF
+//
+// A request may also move a run of consecutive sectors on one track, 
+// each to or from its own buffer.  The head waits for the first sector
+// to come around, as for a single sector, and then transfers the rest 
+// as they pass under it, one RotationTime each.
 
 #define SectorSize 		128	// number of bytes per disk sector
-#define SectorsPerTrack 	32	// number of sectors per disk track 
-#define NumTracks 		32	// number of tracks per disk
-#define NumSectors 		(SectorsPerTrack * NumTracks)
-					// total # of sectors per disk
+#define DefaultSectorsPerTrack 	32	// number of sectors per disk track,
+#define DefaultNumTracks 	32	// and of tracks per disk, unless
+					// the disk is formatted otherwise
 
 class Disk {
   public:
-    Disk(char* name, VoidFunctionPtr callWhenDone, int callArg);
+    Disk(char* name, VoidFunctionPtr callWhenDone, int callArg,
+	 bool mapped = FALSE, int tracks = 0, int trackSectors = 0);
     					// Create a simulated disk.  
 					// Invoke (*callWhenDone)(callArg) 
 					// every time a request completes.
+					// If "mapped", map the UNIX file
+					// into memory.  If "tracks" is
+					// not 0, (re)label the disk with
+					// the given geometry.
     ~Disk();				// Deallocate the disk.
+
+    int NumTracks() { return numTracks; }
+    int SectorsPerTrack() { return sectorsPerTrack; }
+    int NumSectors() { return numSectors; }
+					// the geometry of the disk
     
     void ReadRequest(int sectorNumber, char* data);
     					// Read/write an single disk sector.
@@ -66,17 +95,31 @@ class Disk {
     					// the disk and return immediately.
     					// Only one request allowed at a time!
     void WriteRequest(int sectorNumber, char* data);
+    void ReadRequest(int sectorNumber, char** data, int count);
+    void WriteRequest(int sectorNumber, char** data, int count);
+					// Read/write "count" sectors
+					// on the same track, starting at
+					// "sectorNumber", one buffer each
+    void WriteNow(int sectorNumber, char* data);
+					// Write a sector to the disk file 
+					// right away, with no interrupt --
+					// for when the machine halts
 
     void HandleInterrupt();		// Interrupt handler, invoked when
 					// disk request finishes.
 
-    int ComputeLatency(int newSector, bool writing);	
+    int ComputeLatency(int newSector, bool writing, int count = 1);
     					// Return how long a request to 
 					// newSector will take: 
 					// (seek + rotational delay + transfer)
 
   private:
     int fileno;				// UNIX file number for simulated disk 
+    int numTracks;			// geometry, from the label
+    int sectorsPerTrack;
+    int numSectors;			// numTracks * sectorsPerTrack
+    char *image;			// the UNIX file, mapped into memory;
+					// NULL if it is not
     VoidFunctionPtr handler;		// Interrupt handler, to be invoked 
 					// when any disk request finishes
     int handlerArg;			// Argument to interrupt handler 
@@ -88,6 +131,7 @@ class Disk {
     int TimeToSeek(int newSector, int *rotate); // time to get to the new track
     int ModuloDiff(int to, int from);        // # sectors between to and from
     void UpdateLast(int newSector);
+    void CheckRequest(int sectorNumber, int count);
 };
 
 #endif // DISK_H
@@ -28,7 +28,10 @@
 
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "elevator", "network send", 
+			"network recv", "alarm"};
+
+SLAB_ALLOCATED(PendingInterrupt)		// see slab.h
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -60,7 +63,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new IntrusiveList<PendingInterrupt>;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -74,7 +77,7 @@ Interrupt::Interrupt()
 Interrupt::~Interrupt()
 {
     while (!pending->IsEmpty())
-	delete (PendingInterrupt *)pending->Remove();
+	delete pending->Remove();
     delete pending;
 }
 
@@ -203,6 +206,8 @@ Interrupt::YieldOnReturn()
 //	Since something has to be running in order to put a thread
 //	on the ready queue, the only thing to do is to advance 
 //	simulated time until the next scheduled hardware interrupt.
+//	Threads sleeping on the alarm clock are woken by an AlarmInt
+//	scheduled for the next expiry, so idle time jumps straight there.
 //
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
@@ -245,6 +250,13 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    PrintSlabStats();
+    if (latency != NULL)
+	latency->Print();
+#ifdef USER_PROGRAM
+    if (profiler != NULL)
+	profiler->Write();
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -300,8 +312,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
+    PendingInterrupt *toOccur = pending->SortedRemove(&when);
 
     if (toOccur == NULL)		// no pending interrupts
 	return FALSE;			
@@ -327,6 +338,8 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (machine != NULL)
     	machine->DelayedLoad(0, 0);
 #endif
+    if (tracer != NULL)
+	tracer->InterruptHandler(intTypeNames[toOccur->type]);
     inHandler = TRUE;
     status = SystemMode;			// whatever we were doing,
 						// we are now going to be
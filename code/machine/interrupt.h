@@ -36,7 +36,9 @@
 #define INTERRUPT_H
 
 #include "copyright.h"
+#include "slab.h"
 #include "list.h"
+#include "ilist.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -48,9 +50,11 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network.  AlarmInt is a second timer,
+// programmed by the kernel to wake up sleeping threads (see alarm.h).
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				ElevatorInt, NetworkSendInt, NetworkRecvInt};
+				ElevatorInt, NetworkSendInt, NetworkRecvInt,
+				AlarmInt };
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -58,6 +62,9 @@ enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
 
 class PendingInterrupt {
   public:
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *object);	// see slab.h
+
     PendingInterrupt(VoidFunctionPtr func, int param, int time, IntType kind);
 				// initialize an interrupt that will
 				// occur in the future
@@ -67,6 +74,8 @@ class PendingInterrupt {
     int arg;                    // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    IntrusiveLink<PendingInterrupt> link;	// our place on the 
+				// pending list, sorted by "when"
 };
 
 // The following class defines the data structures for the simulation
@@ -95,6 +104,7 @@ class Interrupt {
     void YieldOnReturn();		// cause a context switch on return 
 					// from an interrupt handler
 
+    bool isInHandler() { return inHandler; } // in an interrupt handler?
     MachineStatus getStatus() { return status; } // idle, kernel, user
     void setStatus(MachineStatus st) { status = st; }
 
@@ -114,7 +124,7 @@ class Interrupt {
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
+    IntrusiveList<PendingInterrupt> *pending; // the interrupts scheduled
 				// to occur in the future
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
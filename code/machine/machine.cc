@@ -56,6 +56,7 @@ Machine::Machine(bool debug)
 
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
+    llBit = FALSE;
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
@@ -97,15 +98,21 @@ Machine::~Machine()
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    int pc = registers[PCReg];		// for the profiler
+    int start = stats->totalTicks;
+
     DEBUG('m', "Exception: %s\n", exceptionNames[which]);
     
 //  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
+    llBit = FALSE;			// the kernel may change memory
     DelayedLoad(0, 0);			// finish anything in progress
     interrupt->setStatus(SystemMode);
     interrupt->OneTick();
     ExceptionHandler(which);		// interrupts are enabled at this point
     interrupt->setStatus(UserMode);
+    if (profiler != NULL && which == PageFaultException)
+	profiler->Stall(pc, stats->totalTicks - start);
 }
 
 //----------------------------------------------------------------------
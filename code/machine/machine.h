@@ -171,6 +171,11 @@ class Machine {
     char *mainMemory;		// physical memory to store user program,
 				// code and data, while executing
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
+    bool llBit;			// has nothing happened since the last LL
+				// that could break its atomicity with an
+				// SC? (cleared by exceptions and user
+				// context switches)
+    int llAddr;			// the address of the last LL
 
 
 // NOTE: the hardware translation of virtual addresses in the user program
@@ -277,6 +277,21 @@ Machine::OneInstruction(Instruction *instr)
 	nextLoadValue = value;
 	break;
     	
+      case OP_LL:			// LW, and remember the address,
+					// for a following SC
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!machine->ReadMem(tmp, 4, &value))
+	    return;
+	llBit = TRUE;
+	llAddr = tmp;
+	nextLoadReg = instr->rt;
+	nextLoadValue = value;
+	break;
+    	
       case OP_LWL:	  
 	tmp = registers[instr->rs] + instr->extra;
 
@@ -474,6 +489,24 @@ Machine::OneInstruction(Instruction *instr)
 	    return;
 	break;
 	
+      case OP_SC:			// SW, but only if nothing could
+					// have changed the word since the LL;
+					// rt says whether the store happened
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (llBit && llAddr == tmp) {
+	    if (!machine->WriteMem(tmp, 4, registers[instr->rt]))
+		return;			// the fault cleared llBit, so
+					// the SC fails when retried
+	    registers[instr->rt] = 1;
+	} else
+	    registers[instr->rt] = 0;
+	llBit = FALSE;
+	break;
+	
       case OP_SWL:	  
 	tmp = registers[instr->rs] + instr->extra;
 
@@ -556,6 +589,13 @@ Machine::OneInstruction(Instruction *instr)
     
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
+
+    if (profiler != NULL)
+	profiler->Executed(registers[PCReg], instr->opCode, pcAfter,
+	    (instr->opCode == OP_JAL || instr->opCode == OP_JALR) ? ProfileCall 
+	    : (instr->opCode == OP_JR && instr->rs == RetAddrReg) ? 
+							ProfileReturn 
+	    : ProfileStep);
     
     // Advance program counters.
     registers[PrevPCReg] = registers[PCReg];	// for debugging, in case we
@@ -565,6 +605,25 @@ Machine::OneInstruction(Instruction *instr)
     interrupt->OneTick();
 }
 
+//----------------------------------------------------------------------
+// OpName
+// 	Put the mnemonic for an opcode -- the first word of its entry in 
+//	opStrings -- in "buf", for the profiler.
+//----------------------------------------------------------------------
+
+void
+OpName(int opCode, char *buf, int size)
+{
+    int i;
+    char *str;
+
+    ASSERT(opCode >= 0 && opCode <= MaxOpcode);
+    str = opStrings[opCode].string;
+    for (i = 0; i < size - 1 && str[i] != ' ' && str[i] != '\0'; i++)
+	buf[i] = str[i];
+    buf[i] = '\0';
+}
+
 //----------------------------------------------------------------------
 // Machine::DelayedLoad
 // 	Simulate effects of a delayed load.
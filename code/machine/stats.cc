@@ -20,8 +20,11 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numDiskSeeks = diskSeekTicks = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numCacheHits = numCacheMisses = numCacheEvictions = 0;
+    numReadAheads = numReadAheadHits = 0;
 }
 
 //----------------------------------------------------------------------
@@ -36,9 +39,46 @@ Statistics::Print()
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
+    if (numDiskSeeks > 0)
+	printf("Disk seeks: %d, ticks %d\n", numDiskSeeks, diskSeekTicks);
+    if (numCacheHits + numCacheMisses > 0)
+	printf("Buffer cache: hits %d, misses %d, evictions %d\n", 
+	    numCacheHits, numCacheMisses, numCacheEvictions);
+    if (numReadAheads > 0)
+	printf("Read-ahead: sectors %d, used %d\n", numReadAheads, 
+	    numReadAheadHits);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 }
+
+//----------------------------------------------------------------------
+// Statistics::Add
+// 	Add the performance metrics of another simulation to ours, to
+//	report the totals over several simulations (see simdriver.cc).
+//----------------------------------------------------------------------
+
+void
+Statistics::Add(Statistics *other)
+{
+    totalTicks += other->totalTicks;
+    idleTicks += other->idleTicks;
+    systemTicks += other->systemTicks;
+    userTicks += other->userTicks;
+    numDiskReads += other->numDiskReads;
+    numDiskWrites += other->numDiskWrites;
+    numDiskSeeks += other->numDiskSeeks;
+    diskSeekTicks += other->diskSeekTicks;
+    numConsoleCharsRead += other->numConsoleCharsRead;
+    numConsoleCharsWritten += other->numConsoleCharsWritten;
+    numPageFaults += other->numPageFaults;
+    numPacketsSent += other->numPacketsSent;
+    numPacketsRecvd += other->numPacketsRecvd;
+    numCacheHits += other->numCacheHits;
+    numCacheMisses += other->numCacheMisses;
+    numCacheEvictions += other->numCacheEvictions;
+    numReadAheads += other->numReadAheads;
+    numReadAheadHits += other->numReadAheadHits;
+}
@@ -30,15 +30,23 @@ class Statistics {
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numDiskSeeks;		// disk requests that moved the head
+    int diskSeekTicks;		// ... and the time spent moving it
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numCacheHits;		// disk sectors found in the buffer cache
+    int numCacheMisses;		// ... and not found
+    int numCacheEvictions;	// sectors evicted from the buffer cache
+    int numReadAheads;		// sectors read into the cache ahead of time
+    int numReadAheadHits;	// ... and then used
 
     Statistics(); 		// initialize everything to zero
 
     void Print();		// print collected statistics
+    void Add(Statistics *other); // add in another simulation's statistics
 };
 
 // Constants used to reflect the relative time an operation would
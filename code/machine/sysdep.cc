@@ -35,6 +35,8 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
+#include <stdlib.h>
+#include <pthread.h>
 #ifdef HOST_i386
 #include <unistd.h>
 #include <sys/time.h>
@@ -265,6 +267,48 @@ Unlink(char *name)
     return unlink(name);
 }
 
+//----------------------------------------------------------------------
+// MapFile
+// 	Map the first "nBytes" of an open file into our address space, 
+//	shared, so that what is written there ends up in the file.  Abort
+//	on error.
+//----------------------------------------------------------------------
+
+char *
+MapFile(int fd, int nBytes)
+{
+    void *addr = mmap(NULL, nBytes, PROT_READ | PROT_WRITE, MAP_SHARED, 
+		      fd, 0);
+
+    ASSERT(addr != MAP_FAILED);
+    return (char *) addr;
+}
+
+//----------------------------------------------------------------------
+// SyncMappedFile
+// 	Write back whatever has changed in a mapped file, and wait until
+//	it is in the file.  Abort on error.
+//----------------------------------------------------------------------
+
+void
+SyncMappedFile(char *addr, int nBytes)
+{
+    int retVal = msync(addr, nBytes, MS_SYNC);
+    ASSERT(retVal == 0);
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Undo MapFile.  Abort on error.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *addr, int nBytes)
+{
+    int retVal = munmap(addr, nBytes);
+    ASSERT(retVal == 0);
+}
+
 //----------------------------------------------------------------------
 // OpenSocket
 // 	Open an interprocess communication (IPC) connection.  For now, 
@@ -442,12 +486,30 @@ Exit(int exitCode)
 // RandomInit
 // 	Initialize the pseudo-random number generator.  We use the
 //	now obsolete "srand" and "rand" because they are more portable!
+//
+//	With glibc, we use the reentrant form of the same generator, 
+//	keeping one state per host thread; a given seed produces
+//	exactly the sequence "srand"/"rand" would.
 //----------------------------------------------------------------------
 
+#ifdef __GLIBC__
+#define RandomStateSize 128		// same as the default for rand()
+
+static HostThreadLocal struct random_data randomData;
+static HostThreadLocal char randomState[RandomStateSize];
+static HostThreadLocal bool randomInitialized = FALSE;
+#endif
+
 void 
 RandomInit(unsigned seed)
 {
+#ifdef __GLIBC__
+    memset(&randomData, 0, sizeof(randomData));
+    initstate_r(seed, randomState, RandomStateSize, &randomData);
+    randomInitialized = TRUE;
+#else
     srand(seed);
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -458,7 +520,110 @@ RandomInit(unsigned seed)
 int 
 Random()
 {
+#ifdef __GLIBC__
+    int32_t result;
+
+    if (!randomInitialized)
+	RandomInit(1);			// rand() is seeded with 1 by default
+    random_r(&randomData, &result);
+    return result;
+#else
     return rand();
+#endif
+}
+
+//----------------------------------------------------------------------
+// HostThreadCreate
+// 	Start a new host (UNIX) thread running "func(arg)".  Returns
+//	a handle to be passed to HostThreadJoin.
+//----------------------------------------------------------------------
+
+struct HostThreadStart {
+    VoidFunctionPtr func;
+    int arg;
+};
+
+static void *
+HostThreadRoot(void *p)
+{
+    HostThreadStart start = *(HostThreadStart *) p;
+
+    delete (HostThreadStart *) p;
+    (*start.func)(start.arg);
+    return NULL;
+}
+
+void *
+HostThreadCreate(VoidFunctionPtr func, int arg)
+{
+    pthread_t *thread = new pthread_t;
+    HostThreadStart *start = new HostThreadStart;
+
+    start->func = func;
+    start->arg = arg;
+    if (pthread_create(thread, NULL, HostThreadRoot, start) != 0) {
+	perror("pthread_create");
+	Abort();
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// HostThreadJoin
+// 	Wait for a host thread started by HostThreadCreate to finish.
+//----------------------------------------------------------------------
+
+void
+HostThreadJoin(void *thread)
+{
+    pthread_join(*(pthread_t *) thread, NULL);
+    delete (pthread_t *) thread;
+}
+
+//----------------------------------------------------------------------
+// HostLockCreate, HostLockAcquire, HostLockRelease, HostLockDelete
+// 	Mutual exclusion between host threads.
+//----------------------------------------------------------------------
+
+void *
+HostLockCreate()
+{
+    pthread_mutex_t *lock = new pthread_mutex_t;
+
+    pthread_mutex_init(lock, NULL);
+    return lock;
+}
+
+void
+HostLockAcquire(void *lock)
+{
+    pthread_mutex_lock((pthread_mutex_t *) lock);
+}
+
+void
+HostLockRelease(void *lock)
+{
+    pthread_mutex_unlock((pthread_mutex_t *) lock);
+}
+
+void
+HostLockDelete(void *lock)
+{
+    pthread_mutex_destroy((pthread_mutex_t *) lock);
+    delete (pthread_mutex_t *) lock;
+}
+
+//----------------------------------------------------------------------
+// HostNumProcessors
+// 	Return the number of CPUs on the host, for sizing thread pools.
+//----------------------------------------------------------------------
+
+int
+HostNumProcessors()
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (n < 1) ? 1 : (int) n;
 }
 
 //----------------------------------------------------------------------
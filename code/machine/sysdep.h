@@ -29,6 +29,13 @@ extern int Tell(int fd);
 extern void Close(int fd);
 extern bool Unlink(char *name);
 
+// Map an open file into memory, so that it can be read and written
+// with memcpy, for simulating the disk; write the changes back to the 
+// file; and unmap it.
+extern char *MapFile(int fd, int nBytes);
+extern void SyncMappedFile(char *addr, int nBytes);
+extern void UnmapFile(char *addr, int nBytes);
+
 // Interprocess communication operations, for simulating the network
 extern int OpenSocket();
 extern void CloseSocket(int sockID);
@@ -46,10 +53,29 @@ extern void Delay(int seconds);
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 
-// Initialize the pseudo random number generator
+// Initialize the pseudo random number generator.  The generator state
+// is private to each host thread, so that simulations run side by side
+// in one UNIX process (see threads/simdriver.cc) do not perturb
+// each other's random sequence.
 extern void RandomInit(unsigned seed);
 extern int Random();
 
+// Storage class for simulator state that must be private to each host
+// thread.  Everything that makes up one simulated machine is declared
+// with it, so that several machines can run in one UNIX process.
+#define HostThreadLocal __thread
+
+// Host threads and locks, for running several independent simulations
+// at once.  These are real (preemptive) host threads -- they must never
+// be used to implement Nachos threads, which are simulated.
+extern void *HostThreadCreate(VoidFunctionPtr func, int arg);
+extern void HostThreadJoin(void *thread);
+extern void *HostLockCreate();
+extern void HostLockAcquire(void *lock);
+extern void HostLockRelease(void *lock);
+extern void HostLockDelete(void *lock);
+extern int HostNumProcessors();	// number of host CPUs available
+
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
 extern char *AllocBoundedArray(int size);
@@ -235,6 +235,8 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	if (entry == NULL) {				// not found
     	    DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
 			TLBMiss++;
+			if (tracer != NULL)
+				tracer->TLBMiss(virtAddr);
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
@@ -347,6 +349,10 @@ int Machine::Invert_LRU_TLB(int virtAddr){
 	return 0;
 }
 int Machine::InvertedAllocatePage(int vpn){
+	if(tracer!=NULL)
+		tracer->PageFault(vpn);
+	if(profiler!=NULL)
+		profiler->PageFault();
 	//choose a physical page 
 	int ppn=0;
 	for(int i=0;i<NumPhysPages;i++){
@@ -424,6 +430,10 @@ int Machine::InvertedAllocatePage(int vpn){
 }
 int Machine::AllocatePhysicalPage(int vpn){
 	//TLB_PageTable_check();
+	if(tracer!=NULL)
+		tracer->PageFault(vpn);
+	if(profiler!=NULL)
+		profiler->PageFault();
 
 	/*choose a physical page*/
 	int ppn=0;
@@ -21,6 +21,8 @@
 #ifdef HOST_SPARC
 #include <strings.h>
 #endif
+SLAB_ALLOCATED(Mail)		// see slab.h
+
 //----------------------------------------------------------------------
 // Mail::Mail
 //      Initialize a single mail message, by concatenating the headers to
@@ -45,13 +47,14 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 //      Initialize a single mail box within the post office, so that it
 //	can receive incoming messages.
 //
-//	Just initialize a list of messages, representing the mailbox.
+//	Just initialize a bounded queue of messages, representing the 
+//	mailbox.
 //----------------------------------------------------------------------
 
 
 MailBox::MailBox()
 { 
-    messages = new SynchList(); 
+    messages = new SynchChannel("mailbox", MailBoxCapacity); 
 }
 
 //----------------------------------------------------------------------
@@ -64,6 +67,10 @@ MailBox::MailBox()
 
 MailBox::~MailBox()
 { 
+    Mail *mail;
+
+    while ((mail = (Mail *) messages->TryRecv()) != NULL)
+	delete mail;
     delete messages; 
 }
 
@@ -86,10 +93,12 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr)
 //----------------------------------------------------------------------
 // MailBox::Put
 // 	Add a message to the mailbox.  If anyone is waiting for message
-//	arrival, wake them up!
+//	arrival, wake them up!  If the mailbox is full, the message is 
+//	dropped, just as if the network had lost it -- the postal worker
+//	must never wait for a slow receiver.
 //
 //	We need to reconstruct the Mail message (by concatenating the headers
-//	to the data), to simplify queueing the message on the SynchList.
+//	to the data), to simplify queueing the message on the SynchChannel.
 //
 //	"pktHdr" -- source, destination machine ID's
 //	"mailHdr" -- source, destination mailbox ID's
@@ -101,9 +110,12 @@ MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 { 
     Mail *mail = new Mail(pktHdr, mailHdr, data); 
 
-    messages->Append((void *)mail);	// put on the end of the list of 
+    if (!messages->TrySend((void *)mail)) {	// put on the end of the 
 					// arrived messages, and wake up 
 					// any waiters
+	DEBUG('n', "Mailbox %d full, dropping mail\n", mailHdr.to);
+	delete mail;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -122,8 +134,8 @@ void
 MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
 { 
     DEBUG('n', "Waiting for mail in mailbox\n");
-    Mail *mail = (Mail *) messages->Remove();	// remove message from list;
-						// will wait if list is empty
+    Mail *mail = (Mail *) messages->Recv();	// remove message from queue;
+						// will wait if it is empty
 
     *pktHdr = mail->pktHdr;
     *mailHdr = mail->mailHdr;
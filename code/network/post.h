@@ -24,6 +24,7 @@
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
+#include "slab.h"
 
 #ifndef POST_H
 #define POST_H
@@ -52,6 +53,11 @@ class MailHeader {
 
 #define MaxMailSize 	(MaxPacketSize - sizeof(MailHeader))
 
+// Most messages a mailbox will hold; the network is unreliable, so 
+// mail arriving at a full mailbox is simply dropped.
+
+#define MailBoxCapacity	32
+
 
 // The following class defines the format of an incoming/outgoing 
 // "Mail" message.  The message format is layered: 
@@ -61,6 +67,9 @@ class MailHeader {
 
 class Mail {
   public:
+     void *operator new(size_t size);	// allocated from a slab cache,
+     void operator delete(void *object);	// see slab.h
+
      Mail(PacketHeader pktH, MailHeader mailH, char *msgData);
 				// Initialize a mail message by
 				// concatenating the headers to the data
@@ -87,7 +96,8 @@ class MailBox {
 				// mailbox (and wait if there is no message 
 				// to get!)
   private:
-    SynchList *messages;	// A mailbox is just a list of arrived messages
+    SynchChannel *messages;	// A mailbox is just a bounded queue of
+				// arrived messages
 };
 
 // The following class defines a "Post Office", or a collection of 
@@ -0,0 +1,60 @@
+/* aio.c 
+ *    Test program for the AioRead, AioWrite and AioWait system calls.
+ *
+ *    Writes a file of zeroes, then starts overwriting every block of 
+ *    it at once, in reverse order, then reads them all back the same 
+ *    way, and checks each block.  (The blocks must exist first, since
+ *    the writes may be done in any order.)  With "-cs 0", every block
+ *    read goes to the disk, and the reads are in flight together, for
+ *    the disk scheduler to sort out: compare the ticks taken under 
+ *    "-ds fcfs" and "-ds clook".
+ */
+
+#include "syscall.h"
+
+#define NumBlocks	16
+#define BlockSize	128
+
+char out[NumBlocks][BlockSize];
+char in[NumBlocks][BlockSize];
+AioId requests[NumBlocks];
+
+int
+main()
+{
+    OpenFileId file;
+    int i, j, bad = 0;
+
+    for (i = 0; i < NumBlocks; i++)
+	for (j = 0; j < BlockSize; j++)
+	    out[i][j] = 'a' + (i + j) % 26;
+
+    Create("aiofile");
+    file = Open("aiofile");
+    Write((char *) in, NumBlocks * BlockSize, file);
+    for (i = NumBlocks - 1; i >= 0; i--)
+	requests[i] = AioWrite(out[i], BlockSize, i * BlockSize, file);
+    for (i = 0; i < NumBlocks; i++)
+	if (AioWait(requests[i]) != BlockSize)
+	    bad++;
+
+    for (i = NumBlocks - 1; i >= 0; i--)
+	requests[i] = AioRead(in[i], BlockSize, i * BlockSize, file);
+    for (i = 0; i < NumBlocks; i++) {
+	if (AioWait(requests[i]) != BlockSize)
+	    bad++;
+	for (j = 0; j < BlockSize; j++)
+	    if (in[i][j] != out[i][j]) {
+		bad++;
+		break;
+	    }
+    }
+    Close(file);
+
+    if (bad == 0)
+	Write("aio ok\n", 7, ConsoleOutput);
+    else
+	Write("aio FAILED\n", 11, ConsoleOutput);
+    Halt();
+    /* not reached */
+}
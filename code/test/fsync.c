@@ -0,0 +1,36 @@
+/* fsync.c 
+ *    Test program for the Fsync and Sync system calls.
+ *
+ *    Writes two files, forcing each to disk with Fsync, then forces the
+ *    rest -- the directory and the free map -- to disk with Sync.  Run 
+ *    it with "-d f" to see the buffer cache write back, or check that 
+ *    the files survive without the cache's help: "nachos -cs 0 -l".
+ */
+
+#include "syscall.h"
+
+char line[] = "written through the buffer cache\n";
+
+void
+WriteLines(char *name, int numLines)
+{
+    OpenFileId file;
+    int i;
+
+    Create(name);
+    file = Open(name);
+    for (i = 0; i < numLines; i++)
+	Write(line, sizeof(line) - 1, file);
+    Fsync(file);
+    Close(file);
+}
+
+int
+main()
+{
+    WriteLines("synced", 8);
+    WriteLines("alsosynced", 4);
+    Sync();
+    Halt();
+    /* not reached */
+}
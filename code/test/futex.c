@@ -0,0 +1,60 @@
+/* futex.c 
+ *    Test program for user-level locks and condition variables.
+ *
+ *    Several threads add to a shared counter under a lock, yielding in
+ *    the middle of the critical section so that the others contend for
+ *    it.  The main thread waits on a condition variable until all of
+ *    them are done, then checks that no increment was lost.
+ */
+
+#include "syscall.h"
+#include "usync.h"
+
+#define NumWorkers	4
+#define NumRounds	20
+
+Mutex lock;
+CondVar allDone;
+int counter;
+int numDone;
+
+void
+Worker()
+{
+    int i, c;
+
+    for (i = 0; i < NumRounds; i++) {
+	MutexLock(&lock);
+	c = counter;
+	Yield();			/* let the others find the lock held */
+	counter = c + 1;
+	MutexUnlock(&lock);
+    }
+    MutexLock(&lock);
+    numDone++;
+    CondSignal(&allDone);
+    MutexUnlock(&lock);
+    Exit(0);
+}
+
+int
+main()
+{
+    int i;
+
+    MutexInit(&lock);
+    CondInit(&allDone);
+    for (i = 0; i < NumWorkers; i++)
+	Fork(Worker);
+
+    MutexLock(&lock);
+    while (numDone < NumWorkers)
+	CondWait(&allDone, &lock);
+    MutexUnlock(&lock);
+
+    if (counter == NumWorkers * NumRounds)
+	Write("futex: ok\n", 10, ConsoleOutput);
+    else
+	Write("futex: lost updates\n", 20, ConsoleOutput);
+    Halt();
+}
@@ -187,6 +187,99 @@ Help:
 	j	$31
 	.end Help
 
+	.globl Sleep
+	.ent Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
+
+	.globl FutexWait
+	.ent FutexWait
+FutexWait:
+	addiu $2,$0,SC_FutexWait
+	syscall
+	j	$31
+	.end FutexWait
+
+	.globl FutexWake
+	.ent FutexWake
+FutexWake:
+	addiu $2,$0,SC_FutexWake
+	syscall
+	j	$31
+	.end FutexWake
+
+	.globl Sync
+	.ent Sync
+Sync:
+	addiu $2,$0,SC_Sync
+	syscall
+	j	$31
+	.end Sync
+
+	.globl Fsync
+	.ent Fsync
+Fsync:
+	addiu $2,$0,SC_Fsync
+	syscall
+	j	$31
+	.end Fsync
+
+	.globl AioRead
+	.ent AioRead
+AioRead:
+	addiu $2,$0,SC_AioRead
+	syscall
+	j	$31
+	.end AioRead
+
+	.globl AioWrite
+	.ent AioWrite
+AioWrite:
+	addiu $2,$0,SC_AioWrite
+	syscall
+	j	$31
+	.end AioWrite
+
+	.globl AioWait
+	.ent AioWait
+AioWait:
+	addiu $2,$0,SC_AioWait
+	syscall
+	j	$31
+	.end AioWait
+
+/* -------------------------------------------------------------
+ * CompareAndSwap
+ *	int CompareAndSwap(int *addr, int old, int new)
+ *	Atomically store "new" in the word at "addr", if it holds "old".
+ *	Returns what the word held before.  If the thread is switched
+ *	out between the LL and the SC, the SC fails, and we try again.
+ *
+ *	The delay slots are filled by hand: the simulator has the
+ *	load delay of the original MIPS, which the assembler does not 
+ *	know about for LL.
+ * -------------------------------------------------------------
+ */
+
+	.globl CompareAndSwap
+	.ent CompareAndSwap
+CompareAndSwap:
+	.set noreorder
+	ll	$2,0($4)
+	nop
+	bne	$2,$5,1f
+	move	$8,$6
+	sc	$8,0($4)
+	beq	$8,$0,CompareAndSwap
+	nop
+1:	j	$31
+	nop
+	.set reorder
+	.end CompareAndSwap
+
 
 
 /* dummy function to keep gcc happy */
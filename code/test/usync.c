@@ -0,0 +1,97 @@
+/* usync.c 
+ *	Locks and condition variables for threads of a user program.
+ *	See usync.h.
+ *
+ *	The lock is the three-state futex mutex of Drepper, "Futexes Are
+ *	Tricky": an uncontended Lock and Unlock each cost one atomic
+ *	operation, and no system call.
+ */
+
+#include "syscall.h"
+#include "usync.h"
+
+#define AllThreads	0x7fffffff	/* FutexWake count, to wake everyone */
+
+/* Atomically store "new" in *addr; return the old contents. */
+static int
+Swap(int *addr, int new)
+{
+    int old;
+
+    do {
+	old = *addr;
+    } while (CompareAndSwap(addr, old, new) != old);
+    return old;
+}
+
+void
+MutexInit(Mutex *m)
+{
+    m->state = 0;
+}
+
+void
+MutexLock(Mutex *m)
+{
+    int c;
+
+    if ((c = CompareAndSwap(&m->state, 0, 1)) == 0)
+	return;				/* it was free */
+
+    /* Mark the lock contended before sleeping, so that the holder 
+     * wakes us when it unlocks.  Once we have slept, we take the lock
+     * as contended too, since others may still be waiting.
+     */
+    if (c != 2)
+	c = Swap(&m->state, 2);
+    while (c != 0) {
+	FutexWait(&m->state, 2);
+	c = Swap(&m->state, 2);
+    }
+}
+
+void
+MutexUnlock(Mutex *m)
+{
+    if (Swap(&m->state, 0) == 2)	/* someone may be waiting */
+	FutexWake(&m->state, 1);
+}
+
+void
+CondInit(CondVar *c)
+{
+    c->seq = 0;
+}
+
+void
+CondWait(CondVar *c, Mutex *m)
+{
+    int seq = c->seq;
+
+    MutexUnlock(m);
+    FutexWait(&c->seq, seq);	/* returns at once if signalled since */
+    while (Swap(&m->state, 2) != 0)
+	FutexWait(&m->state, 2);
+}
+
+void
+CondSignal(CondVar *c)
+{
+    int seq;
+
+    do {
+	seq = c->seq;
+    } while (CompareAndSwap(&c->seq, seq, seq + 1) != seq);
+    FutexWake(&c->seq, 1);
+}
+
+void
+CondBroadcast(CondVar *c)
+{
+    int seq;
+
+    do {
+	seq = c->seq;
+    } while (CompareAndSwap(&c->seq, seq, seq + 1) != seq);
+    FutexWake(&c->seq, AllThreads);
+}
@@ -0,0 +1,42 @@
+/* usync.h 
+ *	Locks and condition variables for threads of a user program, built
+ *	on futexes (see FutexWait and FutexWake in syscall.h).
+ *
+ *	Taking a free lock, or releasing one no one waits for, is a single
+ *	atomic instruction sequence in the user program; the kernel is
+ *	only entered to sleep, or to wake a sleeper.
+ */
+
+#ifndef USYNC_H
+#define USYNC_H
+
+/* Atomically store "new" in *addr if it holds "old"; return the old
+ * contents (see start.s).
+ */
+int CompareAndSwap(int *addr, int old, int new);
+
+/* A lock.  "state" is 0 if the lock is free, 1 if it is held and no
+ * one is waiting for it, 2 if it is held and someone may be waiting.
+ */
+typedef struct {
+    int state;
+} Mutex;
+
+void MutexInit(Mutex *m);
+void MutexLock(Mutex *m);
+void MutexUnlock(Mutex *m);
+
+/* A condition variable, with Mesa semantics.  "seq" counts signals,
+ * so that a waiter notices a signal sent between releasing the lock 
+ * and going to sleep.
+ */
+typedef struct {
+    int seq;
+} CondVar;
+
+void CondInit(CondVar *c);
+void CondWait(CondVar *c, Mutex *m);
+void CondSignal(CondVar *c);
+void CondBroadcast(CondVar *c);
+
+#endif /* USYNC_H */
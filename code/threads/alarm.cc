@@ -0,0 +1,365 @@
+// alarm.cc 
+//	Routines to implement the alarm clock: a hierarchical timer 
+//	wheel of timeouts, driven by a one-shot timer.
+//
+//	Simulated time only advances, so the wheel is processed lazily:
+//	"wheelTime" catches up with the clock each time the one-shot 
+//	timer goes off, and the timer is always programmed for the next
+//	time at which some slot needs attention -- either a level 0 slot
+//	whose timeouts are due, or a higher level slot whose block is
+//	beginning, so its timeouts must move down a level.
+//
+//	All of these routines assume interrupts are disabled, except 
+//	WaitUntil and Pause.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+// dummy functions because C++ does not allow pointers to member functions
+static void AlarmHandler(int gen)
+{ alarmClock->CallBack(gen); }
+
+static void AlarmWakeUp(int arg)
+{ scheduler->ReadyToRun((Thread *)arg); }
+
+//----------------------------------------------------------------------
+// OneShotTimer::OneShotTimer
+// 	Initialize a one-shot timer.  It does not generate any interrupt
+//	until it is programmed with Arm.
+//
+//	"timerHandler" is the interrupt handler for the timer; it is
+//		passed the generation number of the interrupt, for Expired
+//	"kind" is the type of interrupt the timer raises
+//----------------------------------------------------------------------
+
+OneShotTimer::OneShotTimer(VoidFunctionPtr timerHandler, IntType kind)
+{
+    handler = timerHandler;
+    type = kind;
+    armedAt = -1;
+    pendingAt = -1;
+    generation = 0;
+}
+
+//----------------------------------------------------------------------
+// OneShotTimer::Arm
+// 	Program the timer to go off when simulated time reaches "when"
+//	(or right away, if that time has passed), in place of any earlier
+//	setting.
+//
+//	If the latest interrupt scheduled has yet to arrive, and is due
+//	no later than "when", it will do -- Expired sends it on.  Otherwise
+//	schedule a new one; any earlier ones become stale.
+//----------------------------------------------------------------------
+
+void
+OneShotTimer::Arm(int when)
+{
+    armedAt = when;
+    if (pendingAt != -1 && pendingAt <= when)
+	return;				// an interrupt is on its way
+    pendingAt = when;
+    generation++;
+    interrupt->Schedule(handler, generation, 
+		max(when - stats->totalTicks, 1), type);
+}
+
+//----------------------------------------------------------------------
+// OneShotTimer::Disarm
+// 	Cancel the setting of the timer.  Any interrupt on its way is
+//	now stale.
+//----------------------------------------------------------------------
+
+void
+OneShotTimer::Disarm()
+{
+    armedAt = -1;
+}
+
+//----------------------------------------------------------------------
+// OneShotTimer::Expired
+// 	An interrupt of the timer has arrived, carrying generation number
+//	"gen".  Return TRUE if the timer has gone off, or FALSE if the
+//	interrupt is stale: a later interrupt has replaced it, or the 
+//	timer has been disarmed since.  If the timer has been armed for
+//	a later time since, schedule the interrupt again, for then.
+//----------------------------------------------------------------------
+
+bool
+OneShotTimer::Expired(int gen)
+{
+    if (gen != generation)
+	return FALSE;			// replaced by a later interrupt
+    pendingAt = -1;
+    if (armedAt == -1)
+	return FALSE;			// disarmed
+    if (armedAt > stats->totalTicks) {	// armed again, for later
+	pendingAt = armedAt;
+	generation++;
+	interrupt->Schedule(handler, generation, 
+		armedAt - stats->totalTicks, type);
+	return FALSE;
+    }
+    armedAt = -1;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AlarmEntry::AlarmEntry
+// 	Initialize a timeout that is not yet set.
+//
+//	"func" is the procedure to call when the timeout goes off
+//	"param" is the argument to pass to the procedure
+//----------------------------------------------------------------------
+
+AlarmEntry::AlarmEntry(VoidFunctionPtr func, int param)
+{
+    handler = func;
+    arg = param;
+    when = 0;
+    next = NULL;
+    prevNext = NULL;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize an empty timer wheel, and the one-shot timer that
+//	drives it.  The timer's interrupts are handed to the global
+//	alarmClock, so there is only ever one Alarm.
+//----------------------------------------------------------------------
+
+Alarm::Alarm()
+{
+    for (int level = 0; level < AlarmLevels; level++)
+	for (int slot = 0; slot < AlarmSlots; slot++)
+	    wheel[level][slot] = NULL;
+    wheelTime = stats->totalTicks;
+    numPending = 0;
+    device = new OneShotTimer(AlarmHandler, AlarmInt);
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+// 	De-allocate the alarm clock.  Any timeouts still pending are
+//	simply forgotten.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    delete device;
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+// 	Put the current thread to sleep until simulated time reaches
+//	"when".  Returns right away if that time has passed.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int when)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    AlarmEntry entry(AlarmWakeUp, (int) currentThread);
+
+    if (when > stats->totalTicks) {
+	DEBUG('t', "Thread \"%s\" sleeping until %d\n", 
+		currentThread->getName(), when);
+	Set(&entry, when);
+	currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Pause
+// 	Put the current thread to sleep for "howLong" ticks.
+//----------------------------------------------------------------------
+
+void
+Alarm::Pause(int howLong)
+{
+    WaitUntil(stats->totalTicks + howLong);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Set
+// 	Arrange for entry->handler to be called once simulated time
+//	reaches "when".  The entry must not already be pending.
+//----------------------------------------------------------------------
+
+void
+Alarm::Set(AlarmEntry *entry, int when)
+{
+    ASSERT(!entry->IsPending());
+    if (numPending == 0)		// nothing to catch up on
+	wheelTime = stats->totalTicks;
+    entry->when = max(when, wheelTime + 1);
+    Insert(entry);
+    numPending++;
+    Reprogram();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Cancel
+// 	Take back a timeout, if it has not gone off yet.  The one-shot
+//	timer is left alone; if it goes off for nothing, so be it.
+//----------------------------------------------------------------------
+
+void
+Alarm::Cancel(AlarmEntry *entry)
+{
+    if (!entry->IsPending())
+	return;
+    *entry->prevNext = entry->next;
+    if (entry->next != NULL)
+	entry->next->prevNext = entry->prevNext;
+    entry->next = NULL;
+    entry->prevNext = NULL;
+    numPending--;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Insert
+// 	Put a timeout in the slot for its expiry time.  The level is 
+//	chosen by how far off the timeout is, relative to wheelTime;
+//	timeouts that are already due go in the current level 0 slot.
+//----------------------------------------------------------------------
+
+void
+Alarm::Insert(AlarmEntry *entry)
+{
+    int delta = entry->when - wheelTime;
+    int t = entry->when;
+    int level, slot;
+    AlarmEntry **head;
+
+    if (delta < 0)
+	t = wheelTime;
+    else if (delta >= AlarmRange)	// too far; park it as far out
+	t = wheelTime + AlarmRange - 1;	// as we can, and re-cascade then
+    for (level = 0; level < AlarmLevels - 1; level++)
+	if (t - wheelTime < (1 << (AlarmSlotBits * (level + 1))))
+	    break;
+    slot = (t >> (AlarmSlotBits * level)) & (AlarmSlots - 1);
+
+    head = &wheel[level][slot];
+    entry->next = *head;
+    if (*head != NULL)
+	(*head)->prevNext = &entry->next;
+    entry->prevNext = head;
+    *head = entry;
+}
+
+//----------------------------------------------------------------------
+// Alarm::NextEvent
+// 	Return the next time after wheelTime at which some slot needs
+//	attention, or -1 if the wheel is empty.
+//
+//	Relative to the block wheelTime is in, each occupied slot at a
+//	level is between 1 and AlarmSlots blocks ahead; the first 
+//	occupied one at each level is the next event for that level.
+//----------------------------------------------------------------------
+
+int
+Alarm::NextEvent()
+{
+    int next = -1;
+
+    if (numPending == 0)
+	return -1;
+    for (int level = 0; level < AlarmLevels; level++) {
+	int shift = AlarmSlotBits * level;
+	int block = wheelTime >> shift;
+
+	for (int ahead = 1; ahead <= AlarmSlots; ahead++) {
+	    if (wheel[level][(block + ahead) & (AlarmSlots - 1)] != NULL) {
+		int t = (block + ahead) << shift;
+
+		if (next == -1 || t < next)
+		    next = t;
+		break;
+	    }
+	}
+    }
+    return next;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Advance
+// 	Process the wheel up to time "now": at each time a slot needs
+//	attention, first move the timeouts in any higher level slot whose
+//	block begins then down the wheel, then call the handlers of the
+//	timeouts in the level 0 slot.
+//----------------------------------------------------------------------
+
+void
+Alarm::Advance(int now)
+{
+    int next;
+    AlarmEntry *entry;
+
+    while ((next = NextEvent()) != -1 && next <= now) {
+	wheelTime = next;
+	for (int level = AlarmLevels - 1; level > 0; level--) {
+	    int shift = AlarmSlotBits * level;
+	    AlarmEntry **head;
+
+	    if ((wheelTime & ((1 << shift) - 1)) != 0)
+		continue;		// not the start of a block
+	    head = &wheel[level][(wheelTime >> shift) & (AlarmSlots - 1)];
+	    while ((entry = *head) != NULL) {
+		*head = entry->next;
+		if (*head != NULL)
+		    (*head)->prevNext = head;
+		Insert(entry);		// lands at a lower level
+	    }
+	}
+	while ((entry = wheel[0][wheelTime & (AlarmSlots - 1)]) != NULL) {
+	    Cancel(entry);
+	    DEBUG('i', "Alarm due at %d going off at %d\n", entry->when, 
+		stats->totalTicks);
+	    (*entry->handler)(entry->arg);
+	}
+    }
+    if (now > wheelTime)
+	wheelTime = now;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Reprogram
+// 	Set the one-shot timer for the next time the wheel needs 
+//	attention, if that is earlier than it is set for now.
+//----------------------------------------------------------------------
+
+void
+Alarm::Reprogram()
+{
+    int next = NextEvent();
+    int armed = device->ArmedAt();
+
+    if (next == -1)
+	device->Disarm();
+    else if (armed == -1 || next < armed)
+	device->Arm(next);
+}
+
+//----------------------------------------------------------------------
+// Alarm::CallBack
+// 	An interrupt of generation "gen" has arrived from the one-shot
+//	timer.  If the timer has gone off, wake up everyone who is due,
+//	and set the timer for the next expiry.
+//----------------------------------------------------------------------
+
+void
+Alarm::CallBack(int gen)
+{
+    if (!device->Expired(gen))
+	return;				// stale
+    Advance(stats->totalTicks);
+    Reprogram();
+}
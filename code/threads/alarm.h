@@ -0,0 +1,129 @@
+// alarm.h 
+//	Data structures for an alarm clock, which lets threads sleep
+//	until a given simulated time without busy-waiting.
+//
+//	Pending timeouts are kept in a hierarchical timer wheel: 
+//	AlarmLevels levels of AlarmSlots slots each.  A slot at level
+//	0 holds the timeouts due at one particular tick; a slot at level
+//	L holds those due in one particular block of AlarmSlots^L ticks,
+//	and is "cascaded" down a level when its block begins.  Setting
+//	and cancelling a timeout are O(1).
+//
+//	The wheel is driven by a one-shot timer, which the alarm clock
+//	programs for the next slot that needs attention -- so there is
+//	one interrupt per expiry time, no matter how many threads are
+//	sleeping until then, and none at all while nobody is sleeping.
+//
+//	The hardware timer (timer.h) can only interrupt periodically, so
+//	the one-shot timer is built in the kernel, the same way the
+//	hardware timer is emulated: by scheduling an interrupt for the
+//	time it is to go off.  The scheduler's tickless mode uses one too.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "interrupt.h"
+
+#define AlarmLevels	4
+#define AlarmSlotBits	6
+#define AlarmSlots	(1 << AlarmSlotBits)
+#define AlarmRange	(1 << (AlarmSlotBits * AlarmLevels))
+					// farthest a timeout can be
+					// placed without re-cascading
+
+// The following class defines a one-shot timer: an interrupt of type
+// "kind" that goes off once, when simulated time reaches the time it is
+// armed for.
+//
+// A scheduled interrupt cannot be taken back, so each one carries the
+// timer's generation number, which arming the timer again advances.
+// The owner's interrupt handler passes the number it was given to
+// Expired, which tells it whether the timer really went off, or the
+// interrupt is stale.  Arming the timer for a time no earlier than an
+// interrupt still on its way reuses that interrupt (Expired sends it
+// on to the new time), so that re-arming the timer on every context
+// switch does not pile up interrupts.
+
+class OneShotTimer {
+  public:
+    OneShotTimer(VoidFunctionPtr timerHandler, IntType kind);
+				// Initialize an idle timer; "timerHandler"
+				// is called with the generation number of
+				// each of its interrupts
+    ~OneShotTimer() {}
+
+    void Arm(int when);		// go off when the simulated time reaches
+				// "when" -- replaces any earlier setting
+    void Disarm();		// cancel the setting
+    int ArmedAt() { return armedAt; }	// when the timer will go off,
+				// -1 if not armed
+    bool Expired(int gen);	// an interrupt of generation "gen" has
+				// arrived: has the timer gone off?
+
+  private:
+    VoidFunctionPtr handler;	// interrupt handler
+    IntType type;		// interrupt type to raise
+    int armedAt;		// when to go off, or -1
+    int pendingAt;		// when the latest interrupt scheduled is 
+				// due, or -1 if it has arrived
+    int generation;		// of the latest interrupt scheduled
+};
+
+// The following class defines a timeout: "handler(arg)" is to be
+// called, with interrupts disabled, once simulated time reaches "when".
+// The storage belongs to the caller, which must keep it alive until
+// the timeout goes off or is cancelled.
+
+class AlarmEntry {
+  public:
+    AlarmEntry(VoidFunctionPtr func, int param);
+    bool IsPending() { return prevNext != NULL; }
+
+    VoidFunctionPtr handler;	// what to call,
+    int arg;			// and its argument
+    int when;			// when to call it
+
+    AlarmEntry *next;		// next timeout in the same slot
+    AlarmEntry **prevNext;	// the pointer that points to us, 
+				// NULL if not pending
+};
+
+// The following class defines the alarm clock.
+
+class Alarm {
+  public:
+    Alarm();				// initialize an empty timer wheel
+    ~Alarm();
+
+    void WaitUntil(int when);		// put the current thread to sleep
+					// until simulated time "when"
+    void Pause(int howLong);		// sleep for "howLong" ticks
+
+    void Set(AlarmEntry *entry, int when);	// arrange for a timeout
+    void Cancel(AlarmEntry *entry);	// take back a timeout, if pending
+
+    int NumPending() { return numPending; }	// # of timeouts not
+					// yet gone off
+
+    void CallBack(int gen);		// Called when an interrupt of the
+					// one-shot timer arrives.
+  private:
+    AlarmEntry *wheel[AlarmLevels][AlarmSlots];
+    int wheelTime;			// time up to which the wheel has 
+					// been processed
+    int numPending;			// # of timeouts on the wheel
+    OneShotTimer *device;		// timer that drives us
+
+    void Insert(AlarmEntry *entry);	// put a timeout in its slot
+    int NextEvent();			// when a slot next needs attention
+    void Advance(int now);		// process the wheel up to "now"
+    void Reprogram();			// set the timer for NextEvent()
+};
+
+#endif // ALARM_H
@@ -0,0 +1,244 @@
+// ilist.h 
+//	Data structures for an "intrusive" list -- a doubly linked list
+//	whose links are embedded in the objects on it, rather than
+//	held in separately allocated ListElements.
+//
+//	Putting an object on an intrusive list, or taking it off, never
+//	allocates or frees memory, and an object can be removed from the
+//	middle of its list in constant time.  The price is that an
+//	object can be on at most one list per link it contains -- which
+//	suits the kernel's queues: a thread is on the ready list, or on
+//	the wait queue of one synchronization object, but never on two 
+//	at once.
+//
+//	The list is a template, in the spirit of c++example/templatestack.h.
+//	T is the type of thing on the list; it must have a public member
+//	"IntrusiveLink<T> link".  Unlike templatestack, the functions are
+//	implemented in this file, since every file using the template
+//	needs to see them.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ILIST_H
+#define ILIST_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines the link embedded in each object that
+// can be put on an IntrusiveList.
+
+template <class T>
+class IntrusiveLink {
+  public:
+    IntrusiveLink() { next = prev = NULL; key = 0; onList = NULL; }
+
+    T *next;			// next object on the list, NULL if last
+    T *prev;			// previous object, NULL if first
+    int key;			// priority, for a sorted list
+    void *onList;		// the list we are on, NULL if none
+};
+
+// The following class defines the intrusive list itself.  By using
+// the "Sorted" functions, the list can be kept sorted in increasing
+// order by key; objects with equal keys stay in the order they were
+// inserted.
+
+template <class T>
+class IntrusiveList {
+  public:
+    IntrusiveList();		// initialize the list
+    ~IntrusiveList();		// de-allocate the list -- it must be empty
+
+    void Prepend(T *item);	// Put item at the beginning of the list
+    void Append(T *item);	// Put item at the end of the list
+    T *Remove();		// Take item off the front of the list
+    void Remove(T *item);	// Take item off the list, wherever it is
+    T *Front() { return first; }	// First item, left on the list
+
+    bool IsEmpty() { return first == NULL; }
+    bool IsInList(T *item) { return item->link.onList == this; }
+    int NumInList() { return numInList; }
+
+    void Mapcar(VoidFunctionPtr func);	// Apply "func" to every item
+
+    // Routines to put/get items on/off list in order (sorted by key)
+    void SortedInsert(T *item, int sortKey);	// Put item into list
+    T *SortedRemove(int *keyPtr);		// Remove first item from list
+
+  private:
+    T *first;			// Head of the list, NULL if list is empty
+    T *last;			// Last item on the list
+    int numInList;		// number of items on the list
+
+    void InsertAfter(T *where, T *item);	// link in item after 
+						// "where" (NULL: at front)
+};
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::IntrusiveList
+//	Initialize an empty list.
+//----------------------------------------------------------------------
+
+template <class T>
+IntrusiveList<T>::IntrusiveList()
+{
+    first = last = NULL;
+    numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::~IntrusiveList
+//	The list does not own the objects on it, so there is nothing
+//	to de-allocate; it had better be empty, or those objects would be
+//	left pointing at it.
+//----------------------------------------------------------------------
+
+template <class T>
+IntrusiveList<T>::~IntrusiveList()
+{
+    ASSERT(IsEmpty());
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::InsertAfter
+//	Link "item" into the list after "where", or at the front if
+//	"where" is NULL.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::InsertAfter(T *where, T *item)
+{
+    ASSERT(item->link.onList == NULL);	// on one list at a time!
+
+    item->link.prev = where;
+    item->link.next = (where == NULL) ? first : where->link.next;
+    if (item->link.next == NULL)
+	last = item;
+    else
+	item->link.next->link.prev = item;
+    if (where == NULL)
+	first = item;
+    else
+	where->link.next = item;
+    item->link.onList = this;
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Prepend, Append
+//	Put an item at the beginning, or the end, of the list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Prepend(T *item)
+{
+    item->link.key = 0;
+    InsertAfter(NULL, item);
+}
+
+template <class T>
+void
+IntrusiveList<T>::Append(T *item)
+{
+    item->link.key = 0;
+    InsertAfter(last, item);
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Remove
+//	Take "item" off the list, wherever it is.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Remove(T *item)
+{
+    ASSERT(IsInList(item));
+
+    if (item->link.prev == NULL)
+	first = item->link.next;
+    else
+	item->link.prev->link.next = item->link.next;
+    if (item->link.next == NULL)
+	last = item->link.prev;
+    else
+	item->link.next->link.prev = item->link.prev;
+    item->link.next = item->link.prev = NULL;
+    item->link.onList = NULL;
+    numInList--;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Remove
+//	Take the first item off the list, and return it; return NULL
+//	if the list is empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T *
+IntrusiveList<T>::Remove()
+{
+    return SortedRemove(NULL);
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Mapcar
+//	Apply a function to each item on the list, front to back.
+//	The function must not take the item off the list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Mapcar(VoidFunctionPtr func)
+{
+    for (T *ptr = first; ptr != NULL; ptr = ptr->link.next)
+	(*func)((int) ptr);
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::SortedInsert
+//	Insert an item into the list, after every item whose key is less
+//	than or equal to "sortKey".  The search starts from the back of
+//	the list, so items of the same priority queue up in constant time.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::SortedInsert(T *item, int sortKey)
+{
+    T *ptr;
+
+    for (ptr = last; ptr != NULL && sortKey < ptr->link.key; 
+						ptr = ptr->link.prev)
+	;
+    item->link.key = sortKey;
+    InsertAfter(ptr, item);
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::SortedRemove
+//	Remove the first item from the list, and return it, setting 
+//	*keyPtr to its key (if keyPtr is not NULL).  Returns NULL if the
+//	list is empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T *
+IntrusiveList<T>::SortedRemove(int *keyPtr)
+{
+    T *item = first;
+
+    if (item == NULL)
+	return NULL;
+    if (keyPtr != NULL)
+	*keyPtr = item->link.key;
+    Remove(item);
+    return item;
+}
+
+#endif // ILIST_H
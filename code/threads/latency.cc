@@ -0,0 +1,252 @@
+// latency.cc 
+//	Routines for measuring how long threads wait, and for printing
+//	the results as histograms.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "latency.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Histogram::Histogram
+// 	Initialize an empty histogram.
+//
+//	"debugName" is what is being measured, for printing.
+//----------------------------------------------------------------------
+
+Histogram::Histogram(char *debugName)
+{
+    name = debugName;
+    for (int i = 0; i < NumHistBuckets; i++)
+	buckets[i] = 0;
+    count = max = 0;
+    total = 0;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Record
+// 	Count one more time in the histogram.  Time 0 goes in bucket 0,
+//	and time t > 0 in bucket 1 + floor(log2(t)).
+//
+//	"ticks" is the time to record.
+//----------------------------------------------------------------------
+
+void
+Histogram::Record(int ticks)
+{
+    int bucket = 0;
+
+    ASSERT(ticks >= 0);
+    for (int t = ticks; t > 0 && bucket < NumHistBuckets - 1; t >>= 1)
+	bucket++;
+    buckets[bucket]++;
+    count++;
+    total += ticks;
+    if (ticks > max)
+	max = ticks;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Print
+// 	Print the count, mean and maximum of the times recorded, and then
+//	a line for each bucket that is not empty.
+//----------------------------------------------------------------------
+
+void
+Histogram::Print()
+{
+    printf("%s: %d, mean %.1f, max %d ticks\n", name, count, 
+	   (count > 0) ? total / count : 0.0, max);
+    for (int i = 0; i < NumHistBuckets; i++) {
+	int low = (i == 0) ? 0 : 1 << (i - 1);
+
+	if (buckets[i] == 0)
+	    continue;
+	if (i <= 1)
+	    printf("  %9d        : %d\n", low, buckets[i]);
+	else if (i < NumHistBuckets - 1)
+	    printf("  %9d..%-7d: %d\n", low, (1 << i) - 1, buckets[i]);
+	else
+	    printf("  %9d..      : %d\n", low, buckets[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::LatencyStats
+// 	Initialize empty histograms, and zero counts.
+//----------------------------------------------------------------------
+
+LatencyStats::LatencyStats()
+    : readyWait("Ready list wait"), 
+      semaphoreWait("Semaphore wait"),
+      lockWait("Lock wait"), 
+      lockHold("Lock hold"),
+      conditionWait("Condition wait")
+{
+    numSemaphoreP = numSemaphoreWaits = 0;
+    numLockAcquires = numLockWaits = 0;
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::Now
+// 	Return the current simulated time.
+//----------------------------------------------------------------------
+
+int
+LatencyStats::Now()
+{
+    return stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::Ready
+// 	Note that a thread has just been put on the ready list.
+//----------------------------------------------------------------------
+
+void
+LatencyStats::Ready(Thread *thread)
+{
+    thread->readySince = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::Dispatch
+// 	A thread is about to run; record how long it was ready.  The
+//	main thread never went through Ready.
+//----------------------------------------------------------------------
+
+void
+LatencyStats::Dispatch(Thread *thread)
+{
+    int ticks;
+
+    if (thread->readySince < 0)
+	return;
+    ticks = stats->totalTicks - thread->readySince;
+    readyWait.Record(ticks);
+    thread->readyTicks += ticks;
+    thread->readySince = -1;
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::SemaphoreWait, LatencyStats::LockWait, 
+// LatencyStats::ConditionWait
+// 	A thread has finished waiting on a semaphore, a lock, or a 
+//	condition variable; record how long it was blocked, and put the
+//	wait on the timeline, if one is being traced.
+//
+//	"since" is when it started waiting, from Now().
+//----------------------------------------------------------------------
+
+void
+LatencyStats::SemaphoreWait(Thread *thread, int since)
+{
+    semaphoreWait.Record(stats->totalTicks - since);
+    thread->blockedTicks += stats->totalTicks - since;
+    if (tracer != NULL)
+	tracer->Wait("semaphore", thread, since);
+}
+
+void
+LatencyStats::LockWait(Thread *thread, int since)
+{
+    lockWait.Record(stats->totalTicks - since);
+    thread->blockedTicks += stats->totalTicks - since;
+    if (tracer != NULL)
+	tracer->Wait("lock", thread, since);
+}
+
+void
+LatencyStats::ConditionWait(Thread *thread, int since)
+{
+    conditionWait.Record(stats->totalTicks - since);
+    thread->blockedTicks += stats->totalTicks - since;
+    if (tracer != NULL)
+	tracer->Wait("condition", thread, since);
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::LockHeld
+// 	A lock is being released; record how long it was held.
+//
+//	"since" is when it was acquired, from Now().
+//----------------------------------------------------------------------
+
+void
+LatencyStats::LockHeld(int since)
+{
+    lockHold.Record(stats->totalTicks - since);
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::CountSemaphore, LatencyStats::CountLock
+// 	Count a P, or an Acquire, and whether it had to wait.
+//----------------------------------------------------------------------
+
+void
+LatencyStats::CountSemaphore(bool contended)
+{
+    numSemaphoreP++;
+    if (contended)
+	numSemaphoreWaits++;
+}
+
+void
+LatencyStats::CountLock(bool contended)
+{
+    numLockAcquires++;
+    if (contended)
+	numLockWaits++;
+}
+
+//----------------------------------------------------------------------
+// PrintThreadLatency
+// 	Print how long a thread has spent ready and blocked, in all.
+//
+//	"arg" is the thread, cast to an int, as for ThreadTable::Apply.
+//----------------------------------------------------------------------
+
+void
+PrintThreadLatency(int arg)
+{
+    Thread *thread = (Thread *) arg;
+
+    printf("Thread %s (tid %d): ready %d ticks, blocked %d ticks\n",
+	   thread->getName(), thread->getTid(), thread->readyTicks, 
+	   thread->blockedTicks);
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::ThreadDone
+// 	A thread is going away; print its totals now, since it will not
+//	be in the thread table when the machine halts.
+//----------------------------------------------------------------------
+
+void
+LatencyStats::ThreadDone(Thread *thread)
+{
+    PrintThreadLatency((int) thread);
+}
+
+//----------------------------------------------------------------------
+// LatencyStats::Print
+// 	Print the contention counts, the histograms, and the totals for
+//	the threads that are still around.
+//----------------------------------------------------------------------
+
+void
+LatencyStats::Print()
+{
+    printf("Latency: semaphore P %d, waited %d; lock acquire %d, "
+	   "waited %d\n", numSemaphoreP, numSemaphoreWaits, 
+	   numLockAcquires, numLockWaits);
+    readyWait.Print();
+    semaphoreWait.Print();
+    lockWait.Print();
+    lockHold.Print();
+    conditionWait.Print();
+    threadTable->Apply(PrintThreadLatency);
+}
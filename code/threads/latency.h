@@ -0,0 +1,93 @@
+// latency.h 
+//	Data structures for measuring why threads wait: how long they sit
+//	on the ready list, how long they are blocked on each kind of 
+//	synchronization primitive, how long locks are held, and how often
+//	a primitive is contended.
+//
+//	Measurement is turned on with "-lt"; the global "latency" is NULL
+//	otherwise, and each hook in the scheduler and in synch.cc costs
+//	only a test of that pointer.  All times are in ticks of simulated
+//	time (stats->totalTicks).  The results are printed as histograms 
+//	when the machine halts.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+
+#define NumHistBuckets	24		// bucket i > 0 holds times in
+					// [2^(i-1), 2^i); the last one
+					// holds everything larger
+
+// The following class defines a histogram of times, in power of two
+// buckets, along with their count, total and maximum.
+
+class Histogram {
+  public:
+    Histogram(char *debugName);		// initialize an empty histogram
+
+    void Record(int ticks);		// count one more time
+    void Print();			// print the non-empty buckets
+
+    int Count() { return count; }
+
+  private:
+    char *name;				// what is being measured
+    int buckets[NumHistBuckets];	// # of times in each bucket
+    int count;				// # of times recorded
+    double total;			// sum of the times
+    int max;				// longest time recorded
+};
+
+// The following class collects the latency histograms, and the
+// contention counts, for one simulated machine.  The scheduler and the 
+// synchronization routines call it, with interrupts disabled, at each 
+// point where a thread starts or stops waiting.
+
+class LatencyStats {
+  public:
+    LatencyStats();			// initialize empty histograms
+
+    void Ready(Thread *thread);		// thread put on the ready list
+    void Dispatch(Thread *thread);	// thread taken off it, to run
+
+    int Now();				// the time, to pass to the 
+					// routines below
+    void SemaphoreWait(Thread *thread, int since);
+					// a P had to wait, from "since"
+    void LockWait(Thread *thread, int since);
+					// an Acquire had to wait
+    void LockHeld(int since);		// a lock, acquired at "since", 
+					// was released
+    void ConditionWait(Thread *thread, int since);
+					// a Wait was signalled
+
+    void CountSemaphore(bool contended);// a P was done; did it wait?
+    void CountLock(bool contended);	// an Acquire was done
+
+    void ThreadDone(Thread *thread);	// thread is being deleted; print
+					// how long it waited in all
+    void Print();			// print everything
+
+  private:
+    Histogram readyWait;		// time on the ready list
+    Histogram semaphoreWait;		// time blocked in Semaphore::P
+    Histogram lockWait;			// time blocked in Lock::Acquire
+    Histogram lockHold;			// time from Acquire to Release
+    Histogram conditionWait;		// time blocked in Condition::Wait,
+					// until signalled
+    int numSemaphoreP, numSemaphoreWaits;
+    int numLockAcquires, numLockWaits;
+};
+
+extern void PrintThreadLatency(int arg);// print one thread's waiting times,
+					// for ThreadTable::Apply
+
+#endif // LATENCY_H
@@ -18,6 +18,8 @@
 #include "copyright.h"
 #include "list.h"
 
+SLAB_ALLOCATED(ListElement)		// see slab.h
+
 //----------------------------------------------------------------------
 // ListElement::ListElement
 // 	Initialize a list element, so it can be added somewhere on a list.
@@ -130,6 +132,21 @@ List::Remove()
     return SortedRemove(NULL);  // Same as SortedRemove, but ignore the key
 }
 
+//----------------------------------------------------------------------
+// List::Front
+//      Return the first item on the list, leaving it on the list.
+//
+//	Returns NULL if nothing on the list.
+//----------------------------------------------------------------------
+
+void *
+List::Front()
+{
+    if (IsEmpty())
+	return NULL;
+    return first->item;
+}
+
 //----------------------------------------------------------------------
 // List::Mapcar
 //	Apply a function to each item on the list, by walking through  
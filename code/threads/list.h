@@ -14,6 +14,7 @@
 #define LIST_H
 
 #include "copyright.h"
+#include "slab.h"
 #include "utility.h"
 
 // The following class defines a "list element" -- which is
@@ -26,6 +27,9 @@
 
 class ListElement {
    public:
+     void *operator new(size_t size);	// allocated from a slab cache,
+     void operator delete(void *object);	// see slab.h
+
      ListElement(void *itemPtr, int sortKey);	// initialize a list element
 
      ListElement *next;		// next element on list, 
@@ -50,6 +54,7 @@ class List {
     void *Remove(); 	 	// Take item off the front of the list
 
     void Remove(void *item);    // Remove specific item from list
+    void *Front();		// Return first item, without removing it
 
     void Mapcar(VoidFunctionPtr func);	// Apply "func" to every element 
 					// on the list
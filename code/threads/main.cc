@@ -8,31 +8,88 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
+// Usage: nachos -d <debugflags> -rs <random seed #> -tl -ss <words> -lt
+//		-tr <trace file> -q <test #>
 //		-s -x <nachos file> -c <consoleIn> <consoleOut>
-//		-f -cp <unix file> <nachos file>
-//		-p <nachos file> -r <nachos file> -l -D -t
+//		-pf <profile file> -ps <symbol file>
+//		-f -cs <sectors> -cr <lru|2q|arc> -fa <ticks>
+//		-ds <fcfs|sstf|clook> -dm -dg <tracks> <sectors per track>
+//		-dv <stripe|mirror> <disks>
+//		-cp <unix file> <nachos file>
+//		-p <nachos file> -r <nachos file> -l -D -t -cb
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
 //              -z
+//              -sweep <job file> [<# host threads>]
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -tl "tickless" time slicing: the timer only interrupts when some
+//	 other thread is ready to run (with -rs, after a random slice)
+//    -ss sets the size of thread stacks, in words
+//    -lt measures how long threads wait -- on the ready list, and on
+//	 semaphores, locks and condition variables -- and prints 
+//	 histograms when the machine halts
+//    -tr writes a timeline of thread switches, interrupts, disk requests,
+//	 page faults, TLB misses and system calls to the trace file, in
+//	 Chrome's trace-event format (open it in chrome://tracing or 
+//	 Perfetto); with -lt, waits on semaphores, locks and condition
+//	 variables too
 //    -z prints the copyright message
+//    -sweep runs each line of the job file as a separate simulation,
+//	 all in this process, and prints their combined statistics.  
+//	 Each simulation keeps its disk in job<n>.DISK, rather than DISK.
+//	 Must be the first argument.
+//
+//  THREADS
+//    -q runs one of the thread tests (cf. threadtest.cc):
+//	 2 -- thread ids: 5000 threads, then the lowest freed ids must be
+//	      given out again
+//	 8 -- priority inheritance: how long a high priority thread waits
+//	      for a lock held by a low priority one
+//	 9 -- the alarm clock: threads sleep for lengths spread over the
+//	      levels of the timer wheel
+//	 10 -- reader-writer locks: six readers and two writers share an
+//	       RWLock
+//	 11 -- bounded channels: producers and consumers share a small
+//	       SynchChannel, one item at a time and in batches
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
+//    -pf profiles user programs -- by opcode, instruction and basic block,
+//	 with the ticks lost to TLB misses and page faults -- and writes 
+//	 the results to a file, and call stacks for a flame graph to
+//	 <file>.folded, when the machine halts
+//    -ps names addresses in the profile, from "nm -n" output for the
+//	 program (cf. profile.h)
 //    -c tests the console
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
+//    -cs sets the number of sectors in the disk buffer cache (0 for none)
+//    -cr sets the buffer cache's replacement policy: lru (the default),
+//	 2q or arc (cf. bufcache.h)
+//    -fa sets how many ticks a sector may stay dirty in the buffer cache
+//	 before the flusher thread writes it back (0 for no flusher)
+//    -ds sets the order in which queued disk requests are served: fcfs,
+//	 sstf or clook (the default) (cf. synchdisk.h)
+//    -dm maps the DISK file into memory, rather than reading and writing
+//	 it a sector at a time (cf. disk.h)
+//    -dg sets the geometry of the disk, when it is formatted with -f 
+//	 (the default is 32 tracks of 32 sectors)
+//    -dv makes the file system's volume out of several disks, DISK, DISK1,
+//	 DISK2, ..., either striped or mirrored (cf. synchdisk.h); -f
+//	 records it on the disk, and the file system will not start with
+//	 another -dv
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
 //    -r removes a Nachos file from the file system
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system 
 //    -t tests the performance of the Nachos file system
+//    -cb measures the buffer cache's hit rate, for metadata operations
+//	 mixed with scans of a large file (cf. filesys/test/cachebench)
 //
 //  NETWORK
 //    -n sets the network reliability
@@ -52,69 +109,46 @@
 
 #include "utility.h"
 #include "system.h"
+#include "simdriver.h"
 
 #ifdef THREADS
-extern int testnum;
+extern HostThreadLocal int testnum;
 #endif
 
 // External functions used by this file
 
 extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void),MyTest(void);
+extern void CacheBenchmark(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
 extern void MailTest(int networkID);
 extern void TestMultiThread();
+
 //----------------------------------------------------------------------
-// main
-// 	Bootstrap the operating system kernel.  
-//	
-//	Check command line arguments
-//	Initialize data structures
-//	(optionally) Call test procedure
-//
-//	"argc" is the number of command line arguments (including the name
-//		of the command) -- ex: "nachos -d +" -> argc = 3 
-//	"argv" is an array of strings, one for each command line argument
-//		ex: "nachos -d +" -> argv = {"nachos", "-d", "+"}
+// RunCommands
+// 	Carry out the commands on the Nachos command line, once the 
+//	machine has been initialized.  Also used by the sweep driver,
+//	to run each simulation's command line.
 //----------------------------------------------------------------------
 
-int
-main(int argc, char **argv)
+void
+RunCommands(int argc, char **argv)
 {
     int argCount;			// the number of arguments 
 					// for a particular command
 
-    DEBUG('t', "Entering main");
-    (void) Initialize(argc, argv);
-    
-	#ifdef THREADS
-		/*
-		for (argc--, argv++; argc > 0; argc -= argCount, argv += argCount) {
-		argCount = 1;
-		switch (argv[0][1]) {
-		case 'q':
-			testnum = atoi(argv[1]);
-			argCount++;
-			break;
-                case 'S':
-                        if (argv[0][0]=='T'){
-                                testnum=3;
-                                break;
-                        }
-		default:
-			testnum = 1;
-			break;
-		}
-		}
-
-		ThreadTest();
-		*/
-	#endif
-
     for (argc--, argv++; argc > 0; argc -= argCount, argv += argCount) {
 	argCount = 1;
         if (!strcmp(*argv, "-z"))               // print copyright
             printf (copyright);
+		#ifdef THREADS
+			if (!strcmp(*argv, "-q")) {		// run a thread test
+				ASSERT(argc > 1);
+				testnum = atoi(*(argv + 1));
+				ThreadTest();
+				argCount = 2;
+			}
+		#endif // THREADS
 		#ifdef USER_PROGRAM
 				if (!strcmp(*argv, "-x")) {        	// run a user program
 				ASSERT(argc > 1);
@@ -156,6 +190,8 @@ main(int argc, char **argv)
 					fileSystem->Print();
 			} else if (!strcmp(*argv, "-t")) {	// performance test
 					PerformanceTest();
+			} else if (!strcmp(*argv, "-cb")) {	// cache benchmark
+					CacheBenchmark();
 			}
 			else if(!strcmp(*argv,"-mt")){
 				MyTest();
@@ -173,6 +209,34 @@ main(int argc, char **argv)
 		#endif // NETWORK
     }
 
+}
+
+//----------------------------------------------------------------------
+// main
+// 	Bootstrap the operating system kernel.  
+//	
+//	Check command line arguments
+//	Initialize data structures
+//	(optionally) Call test procedure
+//
+//	"argc" is the number of command line arguments (including the name
+//		of the command) -- ex: "nachos -d +" -> argc = 3 
+//	"argv" is an array of strings, one for each command line argument
+//		ex: "nachos -d +" -> argv = {"nachos", "-d", "+"}
+//----------------------------------------------------------------------
+
+int
+main(int argc, char **argv)
+{
+    DEBUG('t', "Entering main");
+    if (argc > 2 && !strcmp(argv[1], "-sweep")) {
+	RunSweep(argv[2], (argc > 3) ? atoi(argv[3]) : 0);
+	Exit(0);
+    }
+    (void) Initialize(argc, argv);
+    
+    RunCommands(argc, argv);
+
     currentThread->Finish();	// NOTE: if the procedure "main" 
 				// returns, then the program "nachos"
 				// will exit (as any other normal program
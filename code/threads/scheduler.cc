@@ -22,14 +22,26 @@
 #include "scheduler.h"
 #include "system.h"
 
+// dummy function because C++ does not allow pointers to member functions
+static void SliceHandler(int gen)
+{ scheduler->SliceExpired(gen); }
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads to empty.
+//
+//	"tickless" -- time slice with a one-shot timer, armed only when
+//		it is needed, rather than the periodic hardware timer 
+//		(which the caller then does not start)
+//	"randomSlices" -- if true, the time slices are of random, instead
+//		of fixed, length, as with the periodic timer
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(bool tickless, bool randomSlices)
 { 
-    readyList = new List; 
+    readyList = new IntrusiveList<Thread>; 
+    sliceTimer = tickless ? new OneShotTimer(SliceHandler, TimerInt) : NULL;
+    randomize = randomSlices;
 #ifdef SCHED_SLICE
         LastSwitchTick=0;
 #endif
@@ -43,6 +55,7 @@ Scheduler::Scheduler()
 Scheduler::~Scheduler()
 { 
     delete readyList; 
+    delete sliceTimer;
 } 
 
 //----------------------------------------------------------------------
@@ -61,17 +74,32 @@ Scheduler::ReadyToRun (Thread *thread)
         DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
         thread->setStatus(READY);
+        if(latency!=NULL)
+                latency->Ready(thread);
 #ifdef SCHED_PRIO
-        readyList->SortedInsert((void *)thread,thread->getPriority());
+        readyList->SortedInsert(thread,thread->getPriority());
+#endif
+#ifdef SCHED_SLICE
+        readyList->Append(thread);
+#endif
+        ProgramTimer();                 // now that it is on the list
 
-        if(thread!=currentThread&&thread->getPriority()<currentThread->getPriority())
-                currentThread->Yield();
+#ifdef SCHED_PRIO
+        // An interrupt handler (e.g. the alarm clock waking a sleeper)
+        // cannot switch out the interrupted thread itself, and a thread
+        // that is blocked is not competing for the CPU at all
+        if(thread!=currentThread&&thread->getPriority()<currentThread->getPriority()){
+                if(interrupt->isInHandler())
+                        interrupt->YieldOnReturn();
+                else if(currentThread->getStatus()==RUNNING)
+                        currentThread->Yield();
+        }
 #endif
 
 #ifdef SCHED_SLICE
-        readyList->Append((void *)thread);
         int ticks=stats->systemTicks-LastSwitchTick;
-        if(thread!=currentThread&&ticks>=SliceTicks)
+        if(thread!=currentThread&&ticks>=SliceTicks
+                        &&currentThread->getStatus()==RUNNING)
                 currentThread->Yield();
 #endif
 }
@@ -96,12 +124,13 @@ Scheduler::FindNextToRun ()
                 return NULL;
 
         #ifdef SCHED_PRIO
-        Thread * candidate=(Thread *)readyList->Remove();
+        Thread * candidate=readyList->Remove();
         if(currentThread->getStatus()==BLOCKED)                 
                 return candidate;
         else if(candidate->getPriority()>currentThread->getPriority())
         {
                 readyList->SortedInsert(candidate,candidate->getPriority());
+                ProgramTimer();
                 return NULL;
         }
         else
@@ -110,7 +139,7 @@ Scheduler::FindNextToRun ()
 
         #ifdef SCHED_SLICE
                 int ticks=stats->systemTicks-LastSwitchTick;
-                Thread * candidate=(Thread *)readyList->Remove();
+                Thread * candidate=readyList->Remove();
                 if(currentThread->getStatus()==BLOCKED){
                         LastSwitchTick=stats->systemTicks;
                         return candidate;
@@ -121,12 +150,40 @@ Scheduler::FindNextToRun ()
                 }
                 else{
                         readyList->Append(candidate);
+                        ProgramTimer();
                         return NULL;
                 }
 
         #endif
 }
 
+//----------------------------------------------------------------------
+// Scheduler::ChangePriority
+// 	Set the effective priority of a thread, for priority inheritance.
+//	If the thread is on the ready list, move it to its new place.
+//
+//	Assumes interrupts are disabled.
+//
+//	"thread" is the thread whose priority changes.
+//	"prio" is its new effective priority.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ChangePriority(Thread *thread, int prio)
+{
+        if (thread->priority == prio)
+                return;
+        DEBUG('t', "Thread %s priority %d -> %d\n", thread->getName(),
+                thread->priority, prio);
+        thread->priority = prio;
+#ifdef SCHED_PRIO
+        if (thread->getStatus() == READY) {
+                readyList->Remove(thread);
+                readyList->SortedInsert(thread, prio);
+        }
+#endif
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Run
 // 	Dispatch the CPU to nextThread.  Save the state of the old thread,
@@ -158,6 +215,15 @@ Scheduler::Run (Thread *nextThread)
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
+    if (latency != NULL)
+	latency->Dispatch(nextThread);
+    if (tracer != NULL)
+	tracer->Switch(oldThread, nextThread);
+
+    if (sliceTimer != NULL) {
+	sliceTimer->Disarm();		    // nextThread gets a fresh slice,
+	ProgramTimer();			    // if anyone else is waiting
+    }
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
 	  oldThread->getName(), nextThread->getName());
@@ -188,6 +254,47 @@ Scheduler::Run (Thread *nextThread)
     #endif
 }
 
+//----------------------------------------------------------------------
+// Scheduler::ProgramTimer
+// 	In tickless mode (-tl), the timer is a one-shot timer, armed 
+//	only while some thread other than the running one is ready to
+//	run -- for the end of the running thread's time slice.  A thread
+//	running alone is never interrupted to no purpose.
+//
+//	Threads sleeping on the alarm clock do not need the timer; the
+//	alarm clock has its own.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ProgramTimer()
+{
+    int slice;
+
+    if (sliceTimer == NULL)
+	return;
+    if (readyList->IsEmpty())
+	sliceTimer->Disarm();
+    else if (sliceTimer->ArmedAt() == -1) {
+	slice = randomize ? 1 + (Random() % (TimerTicks * 2)) : TimerTicks;
+	sliceTimer->Arm(stats->totalTicks + slice);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SliceExpired
+// 	An interrupt of generation "gen" has arrived from the time-slice
+//	timer.  If the timer has gone off, the running thread's slice is
+//	over: as with the periodic timer (see TimerInterruptHandler in
+//	system.cc), switch threads once the interrupt handler returns.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SliceExpired(int gen)
+{
+    if (sliceTimer->Expired(gen) && interrupt->getStatus() != IdleMode)
+	interrupt->YieldOnReturn();
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
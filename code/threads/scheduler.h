@@ -14,25 +14,44 @@
 #include "list.h"
 #include "thread.h"
 
+class OneShotTimer;
+
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
 
 class Scheduler {
   public:
-    Scheduler();			// Initialize list of ready threads 
+    Scheduler(bool tickless = FALSE, bool randomSlices = FALSE);
+    					// Initialize list of ready threads;
+					// in tickless mode, with a one-shot
+					// time-slice timer
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
+    void ChangePriority(Thread* thread, int prio);
+    					// Give thread a new effective 
+					// priority, keeping the ready
+					// list in order
     void Print();			// Print contents of ready list
+
+    void SliceExpired(int gen);		// Called when an interrupt of the
+					// time-slice timer arrives.
     
   private:
-    List *readyList;  		// queue of threads that are ready to run,
+    IntrusiveList<Thread> *readyList;  // queue of threads that are ready to run,
 				// but not running
 
+    OneShotTimer *sliceTimer;	// tickless mode: time-slice timer,
+				// otherwise NULL
+    bool randomize;		// time slices of random length?
+
+    void ProgramTimer();	// in tickless mode, arm the timer if 
+				// anyone is waiting for the CPU
+
 #ifdef SCHED_SLICE
         int LastSwitchTick;
 #endif
@@ -0,0 +1,228 @@
+// simdriver.cc 
+//	Routines to run many independent simulations in one UNIX process,
+//	on a pool of host threads, and to combine their statistics.
+//
+//	A simulation halts by calling Cleanup, which normally exits the
+//	UNIX process.  In sweep mode, Cleanup instead calls SweepJobDone,
+//	which jumps back to the host thread's driver loop so that it can
+//	collect the statistics and start on the next job.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "simdriver.h"
+#include "system.h"
+
+#include <setjmp.h>
+
+#define MaxJobArgs	32	// max # of arguments on one job line
+#define MaxJobLine	512	// max length of one job line
+
+// External functions used by this file
+
+extern void RunCommands(int argc, char **argv);
+
+// The following class describes one simulation of the sweep.
+
+class SweepJob {
+  public:
+    int argc;			// command line of the simulation,
+    char *argv[MaxJobArgs + 1];	// argv[0] is "nachos"
+    char line[MaxJobLine];	// the job line, for the report
+    char diskName[32];		// UNIX file holding its disk
+    SimContext context;		// the machine, once it is initialized
+    Statistics *stats;		// its statistics, once it has halted
+    jmp_buf *done;		// where to go when it halts
+};
+
+HostThreadLocal SweepJob *sweepJob = NULL;
+
+static SweepJob *jobs;		// every job in the job file
+static int numJobs;
+static int nextJob;		// the next job to be started
+static void *jobLock;		// protects nextJob
+
+//----------------------------------------------------------------------
+// SweepJobDone
+// 	The current simulation has halted, and Cleanup has de-allocated
+//	everything but its statistics.  Return to RunJob.
+//----------------------------------------------------------------------
+
+void
+SweepJobDone()
+{
+    ASSERT(sweepJob != NULL);
+    longjmp(*sweepJob->done, 1);
+}
+
+//----------------------------------------------------------------------
+// SweepDiskName
+// 	Return the name of the UNIX file that holds the current 
+//	simulation's disk: "job<n>.DISK", for the job on line <n> of the
+//	report, so that simulations running side by side never share a
+//	disk.  (The other disks of a volume add 1, 2, ... to it.)
+//----------------------------------------------------------------------
+
+char *
+SweepDiskName()
+{
+    ASSERT(sweepJob != NULL);
+    return sweepJob->diskName;
+}
+
+//----------------------------------------------------------------------
+// RunJob
+// 	Run one simulation to completion on the calling host thread.
+//
+//	The simulation's "main" thread runs on this host thread's stack,
+//	below RunJob's frame, so the frame is still intact when 
+//	SweepJobDone jumps back to it -- from whichever Nachos thread 
+//	happened to halt the machine.
+//----------------------------------------------------------------------
+
+static void
+RunJob(SweepJob *job)
+{
+    jmp_buf done;
+
+    job->done = &done;
+    sweepJob = job;
+    if (setjmp(done) == 0) {
+	Initialize(job->argc, job->argv);
+	job->context.Save();
+	RunCommands(job->argc, job->argv);
+	currentThread->Finish();	// runs until the machine halts
+	ASSERT(FALSE);			// not reached
+    }
+    sweepJob = NULL;
+    job->stats = job->context.stats;	// the only state Cleanup keeps
+}
+
+//----------------------------------------------------------------------
+// SweepWorker
+// 	Body of each host thread in the pool: run jobs until there are 
+//	none left.
+//----------------------------------------------------------------------
+
+static void
+SweepWorker(int dummy)
+{
+    for (;;) {
+	int which;
+
+	HostLockAcquire(jobLock);
+	which = nextJob++;
+	HostLockRelease(jobLock);
+	if (which >= numJobs)
+	    return;
+	RunJob(&jobs[which]);
+    }
+}
+
+//----------------------------------------------------------------------
+// ParseJob
+// 	Split a job line into a command line for Initialize and
+//	RunCommands.  Return FALSE if the line is blank or a comment.
+//----------------------------------------------------------------------
+
+static bool
+ParseJob(SweepJob *job, char *line)
+{
+    char *word;
+    char *p;
+
+    if ((p = strchr(line, '\n')) != NULL)
+	*p = '\0';
+    strncpy(job->line, line, MaxJobLine);
+    job->line[MaxJobLine - 1] = '\0';
+
+    job->argc = 0;
+    job->argv[job->argc++] = "nachos";
+    for (word = strtok(line, " \t"); word != NULL; word = strtok(NULL, " \t")) {
+	if (word[0] == '#')
+	    break;			// rest of the line is a comment
+	ASSERT(job->argc < MaxJobArgs);
+	job->argv[job->argc] = new char[strlen(word) + 1];
+	strcpy(job->argv[job->argc++], word);
+    }
+    job->argv[job->argc] = NULL;
+    job->stats = NULL;
+    return (job->argc > 1);
+}
+
+//----------------------------------------------------------------------
+// RunSweep
+// 	Run every simulation in the job file, one per line, on a pool 
+//	of host threads, then print each simulation's statistics and
+//	their totals.
+//
+//	"jobFile" -- UNIX file listing the simulations
+//	"numWorkers" -- how many host threads to use; <= 0 means one
+//		per host CPU
+//----------------------------------------------------------------------
+
+void
+RunSweep(char *jobFile, int numWorkers)
+{
+    char line[MaxJobLine];
+    FILE *fp;
+    int i, maxJobs;
+    void **workers;
+    Statistics total;
+
+    if ((fp = fopen(jobFile, "r")) == NULL) {
+	printf("Unable to open job file %s\n", jobFile);
+	return;
+    }
+    for (maxJobs = 0; fgets(line, MaxJobLine, fp) != NULL; maxJobs++)
+	;
+    rewind(fp);
+    jobs = new SweepJob[maxJobs];
+    for (numJobs = 0; fgets(line, MaxJobLine, fp) != NULL; )
+	if (ParseJob(&jobs[numJobs], line)) {
+	    sprintf(jobs[numJobs].diskName, "job%d.DISK", numJobs);
+	    numJobs++;
+	}
+    fclose(fp);
+
+    if (numWorkers <= 0)
+	numWorkers = HostNumProcessors();
+    if (numWorkers > numJobs)
+	numWorkers = numJobs;
+    printf("Sweep: %d simulations on %d host threads\n", numJobs, 
+	numWorkers);
+
+    jobLock = HostLockCreate();
+    nextJob = 0;
+    workers = new void *[numWorkers];
+    for (i = 0; i < numWorkers; i++)
+	workers[i] = HostThreadCreate(SweepWorker, 0);
+    for (i = 0; i < numWorkers; i++)
+	HostThreadJoin(workers[i]);
+    delete [] workers;
+    HostLockDelete(jobLock);
+
+    printf("\nSweep results:\n");
+    for (i = 0; i < numJobs; i++) {
+	Statistics *s = jobs[i].stats;
+
+	printf("[%d] %s\n", i, jobs[i].line);
+	printf("    ticks %d (idle %d, system %d, user %d), "
+	    "disk %d/%d, faults %d\n", s->totalTicks, s->idleTicks, 
+	    s->systemTicks, s->userTicks, s->numDiskReads, 
+	    s->numDiskWrites, s->numPageFaults);
+	if (s->numCacheHits + s->numCacheMisses > 0)
+	    printf("    cache hits %d, misses %d\n", s->numCacheHits, 
+		s->numCacheMisses);
+	if (s->numDiskSeeks > 0)
+	    printf("    disk seeks %d, ticks %d\n", s->numDiskSeeks, 
+		s->diskSeekTicks);
+	total.Add(s);
+	delete s;
+    }
+    printf("\nTotal over %d simulations:\n", numJobs);
+    total.Print();
+    delete [] jobs;
+}
@@ -0,0 +1,46 @@
+// simdriver.h 
+//	Data structures for running many independent Nachos simulations
+//	in one UNIX process, for design-space sweeps.
+//
+//	Each simulation is described by one line of a job file, holding
+//	the command line arguments it would have been given as a separate
+//	"nachos" process (e.g., "-rs 7 -x ../test/sort").  The jobs are 
+//	run on a pool of host threads, one simulation per host thread at 
+//	a time, and their statistics are combined into one report.
+//
+//	All simulator state, the thread tests' included, is private to a
+//	host thread (see HostThreadLocal in sysdep.h), and each simulation
+//	keeps its disk in a UNIX file of its own, so the simulations do
+//	not interfere.  They do share the rest of the host file system --
+//	for instance, the UNIX files that user programs are loaded from,
+//	and the sockets of the network assignment.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SIMDRIVER_H
+#define SIMDRIVER_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class SweepJob;
+
+// The job the calling host thread is running, or NULL if Nachos 
+// was started normally.
+extern HostThreadLocal SweepJob *sweepJob;
+
+// Called by Cleanup when a simulation halts in sweep mode, instead
+// of exiting the UNIX process.  Never returns.
+extern void SweepJobDone();
+
+// The UNIX file holding the disk of the job the calling host thread
+// is running, in place of "DISK".
+extern char *SweepDiskName();
+
+// Run every simulation listed in "jobFile", using "numWorkers" host 
+// threads (all host CPUs if numWorkers <= 0), and print a report.
+extern void RunSweep(char *jobFile, int numWorkers);
+
+#endif // SIMDRIVER_H
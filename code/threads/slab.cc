@@ -0,0 +1,157 @@
+// slab.cc 
+//	Routines to manage caches of kernel objects.  See slab.h.
+//
+//	An object's size is rounded up to a multiple of 8 bytes, so every
+//	object in a chunk is aligned for any type, and has room for the
+//	free list link.  The first 8 bytes of each chunk link it to the
+//	next chunk of the cache.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "slab.h"
+
+#define SlabAlign	8		// object and chunk header alignment
+
+static HostThreadLocal SlabCache *slabCaches = NULL;
+					// caches used so far, in order
+
+//----------------------------------------------------------------------
+// SlabCache::Alloc
+// 	Return an object for "new", taking it off the free list.  If the
+//	free list is empty, carve a new chunk into objects, and put them
+//	on the free list first.
+//
+//	"size" is the size of the object; it must be the size of the
+//	class the cache was set up for (the class may not be sub-classed).
+//----------------------------------------------------------------------
+
+void *
+SlabCache::Alloc(size_t size)
+{
+    void *object;
+
+    ASSERT((int) size <= objectSize);
+    if (!registered) {			// first use, since the last Flush
+	SlabCache **pp;
+
+	for (pp = &slabCaches; *pp != NULL; pp = &(*pp)->next)
+	    ;
+	*pp = this;
+	next = NULL;
+	registered = TRUE;
+    }
+    if (freeList == NULL) {
+	int rounded = divRoundUp(objectSize, SlabAlign) * SlabAlign;
+	int perChunk = max(SlabChunkSize / rounded, 1);
+	char *chunk = new char[SlabAlign + perChunk * rounded];
+
+	*(char **) chunk = chunks;
+	chunks = chunk;
+	numChunks++;
+	for (int i = perChunk - 1; i >= 0; i--) {
+	    object = chunk + SlabAlign + i * rounded;
+	    *(void **) object = freeList;
+	    freeList = object;
+	}
+	DEBUG('h', "New chunk of %d %s objects\n", perChunk, name);
+    }
+    object = freeList;
+    freeList = *(void **) object;
+    numAllocs++;
+    numInUse++;
+    if (numInUse > highWater)
+	highWater = numInUse;
+    return object;
+}
+
+//----------------------------------------------------------------------
+// SlabCache::Free
+// 	Put an object back on the free list, for "delete".
+//----------------------------------------------------------------------
+
+void
+SlabCache::Free(void *object)
+{
+    if (object == NULL)
+	return;
+    ASSERT(numInUse > 0);
+    *(void **) object = freeList;
+    freeList = object;
+    numFrees++;
+    numInUse--;
+}
+
+//----------------------------------------------------------------------
+// SlabCache::Print
+// 	Print how much the cache was used.
+//----------------------------------------------------------------------
+
+void
+SlabCache::Print()
+{
+    printf("  %-16s size %4d: allocs %d, frees %d, in use %d, "
+	"high water %d, chunks %d\n", name, objectSize, numAllocs, numFrees,
+	numInUse, highWater, numChunks);
+}
+
+//----------------------------------------------------------------------
+// SlabCache::Flush
+// 	Give the cache's chunks back to the heap, and start the statistics
+//	over, for the next simulation on this host thread.  If any 
+//	object is still in use (it was never deleted), keep the chunks,
+//	rather than pull the memory out from under it.
+//----------------------------------------------------------------------
+
+void
+SlabCache::Flush()
+{
+    if (numInUse == 0) {
+	while (chunks != NULL) {
+	    char *chunk = chunks;
+
+	    chunks = *(char **) chunk;
+	    delete [] chunk;
+	}
+	freeList = NULL;
+	numChunks = 0;
+    }
+    numAllocs = numFrees = 0;
+    highWater = numInUse;
+    registered = FALSE;
+    next = NULL;
+}
+
+//----------------------------------------------------------------------
+// PrintSlabStats
+// 	Print the statistics of every cache used so far, alongside
+//	Statistics::Print.
+//----------------------------------------------------------------------
+
+void
+PrintSlabStats()
+{
+    if (slabCaches == NULL)
+	return;
+    printf("Slab caches:\n");
+    for (SlabCache *cache = slabCaches; cache != NULL; cache = cache->next)
+	cache->Print();
+}
+
+//----------------------------------------------------------------------
+// FlushSlabs
+// 	Flush every cache used so far, when the simulation shuts down.
+//----------------------------------------------------------------------
+
+void
+FlushSlabs()
+{
+    while (slabCaches != NULL) {
+	SlabCache *cache = slabCaches;
+
+	slabCaches = cache->next;
+	cache->Flush();
+    }
+}
@@ -0,0 +1,84 @@
+// slab.h 
+//	Data structures for a simple slab allocator, used for the kernel
+//	objects that are created and destroyed over and over again
+//	(pending interrupts, list elements, mail, file headers, ...).
+//
+//	Each such class gets its own cache.  The cache carves objects out
+//	of big chunks of memory, and keeps the objects that are deleted
+//	on a free list, so that the next "new" of that class pops one off
+//	the list, rather than going to the heap.  The cache also counts 
+//	allocations, so we can see how hard a workload leans on it.
+//
+//	To put a class on a cache, declare
+//
+//		void *operator new(size_t size);
+//		void operator delete(void *object);
+//
+//	in the class, and in its .cc file
+//
+//		SLAB_ALLOCATED(Foo)
+//
+//	which defines a cache for the class, and the two operators.
+//
+//	A cache has no constructor, so that it can be set up statically, 
+//	before anyone calls "new", and so that it can be HostThreadLocal:
+//	each simulation of a sweep (see simdriver.h) has its own caches.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "copyright.h"
+#include "utility.h"
+#include <stddef.h>			// for size_t
+
+#define SlabChunkSize	4096		// bytes of objects per chunk
+
+// The following class defines a cache of objects of one size.
+// The data is public only so that a cache can be statically 
+// initialized; use the member functions.
+
+class SlabCache {
+  public:
+    void *Alloc(size_t size);		// Get an object, off the free list
+					// if there is one
+    void Free(void *object);		// Put an object on the free list
+
+    void Print();			// Print the usage statistics
+    void Flush();			// Give the chunks back to the heap,
+					// if no object is still in use, and
+					// zero the statistics
+
+    char *name;				// the class, for debugging
+    int objectSize;			// bytes per object
+    void *freeList;			// free objects, chained through
+					// their first word
+    char *chunks;			// chunks allocated so far, chained 
+					// through their first word
+    int numChunks;
+    int numAllocs;			// calls to Alloc
+    int numFrees;			// calls to Free
+    int numInUse;			// objects allocated, not yet freed
+    int highWater;			// most objects ever in use at once
+    bool registered;			// on the list of caches in use?
+    SlabCache *next;			// next on the list of caches in use
+};
+
+// Define the cache of class "Class", and its operator new and delete.
+
+#define SLAB_ALLOCATED(Class)						\
+    static HostThreadLocal SlabCache Class##SlabCache = 		\
+				{ #Class, sizeof(Class) };		\
+    void *Class::operator new(size_t size)				\
+	{ return Class##SlabCache.Alloc(size); }			\
+    void Class::operator delete(void *object)				\
+	{ Class##SlabCache.Free(object); }
+
+extern void PrintSlabStats();		// Print the statistics of every 
+					// cache used so far
+extern void FlushSlabs();		// Flush every cache, at shutdown
+
+#endif // SLAB_H
@@ -37,7 +37,7 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List;
+    queue = new IntrusiveList<Thread>;
 }
 
 //----------------------------------------------------------------------
@@ -65,13 +65,21 @@ void
 Semaphore::P()
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+    int since = (latency != NULL) ? latency->Now() : 0;
+    bool waited = (value == 0);
     
     while (value == 0) { 			// semaphore not available
-	queue->Append((void *)currentThread);	// so go to sleep
+	queue->SortedInsert(currentThread, 	// so go to sleep
+		currentThread->getPriority());
 	currentThread->Sleep();
     } 
     value--; 					// semaphore available, 
 						// consume its value
+    if (latency != NULL) {
+	latency->CountSemaphore(waited);
+	if (waited)
+	    latency->SemaphoreWait(currentThread, since);
+    }
     
     (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
@@ -90,46 +98,151 @@ Semaphore::V()
     Thread *thread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    thread = (Thread *)queue->Remove();
+    thread = queue->Remove();
     if (thread != NULL)	   // make thread ready, consuming the V immediately
 	scheduler->ReadyToRun(thread);
     value++;
     (void) interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
+//----------------------------------------------------------------------
+// Lock::Lock
+// 	Initialize a lock, so that it can be used for synchronization.
+//	The lock is initially FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
 Lock::Lock(char* debugName) {
-        OwnerId=-1;
-        mutex=new Semaphore("BinarySemaphoreForLock",1);
+        owner=NULL;
+        acquiredAt=0;
+        waiters=new IntrusiveList<Thread>;
+        nextHeld=NULL;
         name=debugName;
 }
+
+//----------------------------------------------------------------------
+// Lock::~Lock
+// 	De-allocate a lock, when no longer needed.  Assume no one
+//	holds it or is waiting for it!
+//----------------------------------------------------------------------
+
 Lock::~Lock() {
-        delete mutex;
+        delete waiters;
+}
+
+//----------------------------------------------------------------------
+// Lock::Donate
+// 	"donor" has just blocked on a lock.  Walk the chain of owners --
+//	the owner of that lock, the owner of the lock that thread is
+//	blocked on, and so on -- raising each one to the donor's priority,
+//	until we reach one that already runs at least that high.
+//
+//	Assumes interrupts are disabled.
+//----------------------------------------------------------------------
+
+void Lock::Donate(Thread *donor) {
+        int prio=donor->getPriority();
+        Lock *lock=donor->waitingFor;
+
+        while(lock!=NULL&&lock->owner!=NULL
+                        &&prio<lock->owner->getPriority()){
+                Thread *holder=lock->owner;
+                scheduler->ChangePriority(holder,prio);
+                lock=holder->waitingFor;
+                if(lock!=NULL){         // keep its wait queue in order
+                        lock->waiters->Remove(holder);
+                        lock->waiters->SortedInsert(holder,prio);
+                }
+        }
+}
+
+//----------------------------------------------------------------------
+// Lock::Recompute
+// 	Set a thread's priority to the highest of its own priority and
+//	those of the threads waiting on the locks it still holds.
+//
+//	Assumes interrupts are disabled.
+//----------------------------------------------------------------------
+
+void Lock::Recompute(Thread *thread) {
+        int prio=thread->getBasePriority();
+
+        for(Lock *lock=thread->heldLocks;lock!=NULL;lock=lock->nextHeld){
+                Thread *top=lock->waiters->Front();
+                if(top!=NULL)
+                        prio=min(prio,top->getPriority());
+        }
+        scheduler->ChangePriority(thread,prio);
 }
+
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then take it.  While we wait, 
+//	lend our priority to the owner.
+//----------------------------------------------------------------------
+
 void Lock::Acquire() {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-    mutex->P();
-    OwnerId=currentThread->getTid();
+    ASSERT(!isHeldByCurrentThread());
+    int since=(latency!=NULL)?latency->Now():0;
+    bool waited=(owner!=NULL);
+    while(owner!=NULL){
+        currentThread->waitingFor=this;
+        waiters->SortedInsert(currentThread,currentThread->getPriority());
+        Donate(currentThread);
+        currentThread->Sleep();
+    }
+    currentThread->waitingFor=NULL;
+    owner=currentThread;
+    nextHeld=owner->heldLocks;
+    owner->heldLocks=this;
+    if(latency!=NULL){
+        latency->CountLock(waited);
+        if(waited)
+            latency->LockWait(currentThread,since);
+        acquiredAt=latency->Now();
+    }
     (void) interrupt->SetLevel(oldLevel);
 }
+
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Set the lock FREE, drop any priority we inherited through it,
+//	and wake up the highest priority waiter, if any.  If the waiter 
+//	outranks us, it runs right away (see Scheduler::ReadyToRun).
+//----------------------------------------------------------------------
+
 void Lock::Release() {
+    Lock **pp;
+    Thread *thread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+
     ASSERT(isHeldByCurrentThread());
-    OwnerId=-1;
-    mutex->V();
+    for(pp=&owner->heldLocks;*pp!=this;pp=&(*pp)->nextHeld)
+        ASSERT(*pp!=NULL);
+    *pp=nextHeld;
+    nextHeld=NULL;
+    owner=NULL;
+    if(latency!=NULL)
+        latency->LockHeld(acquiredAt);
+    Recompute(currentThread);
+
+    thread=waiters->Remove();
+    if(thread!=NULL){
+        thread->waitingFor=NULL;
+        scheduler->ReadyToRun(thread);
+    }
     (void) interrupt->SetLevel(oldLevel);
 }
+
 bool Lock:: isHeldByCurrentThread(){
-        if (OwnerId==currentThread->getTid())
-                return true;
-        return false;
+        return owner==currentThread;
 }
 
 Condition::Condition(char* debugName) { 
         name=debugName;
-        WaitingThreads=new List;
+        WaitingThreads=new IntrusiveList<Thread>;
 }
 Condition::~Condition() {
         delete WaitingThreads;
@@ -138,9 +251,17 @@ Condition::~Condition() {
 //		then re-acquire the lock
 void Condition::Wait(Lock* conditionLock) {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+    // queue up before releasing: Release may switch to a waiter on the
+    // lock, which must be able to Signal us.  We count as blocked from
+    // here on, so that waking a waiter does not put us on the ready list
+    // while we are still on WaitingThreads
+    WaitingThreads->SortedInsert(currentThread,currentThread->getPriority());
+    currentThread->setStatus(BLOCKED);
+    int since=(latency!=NULL)?latency->Now():0;
     conditionLock->Release();
-    WaitingThreads->Append(currentThread);
     currentThread->Sleep();
+    if(latency!=NULL)
+        latency->ConditionWait(currentThread,since);
     conditionLock->Acquire();
     (void) interrupt->SetLevel(oldLevel);
 
@@ -150,7 +271,7 @@ void Condition::Wait(Lock* conditionLock) {
 void Condition::Signal(Lock* conditionLock) {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
     if(conditionLock->isHeldByCurrentThread()&&!WaitingThreads->IsEmpty()){
-            Thread * ToWakeUp=(Thread *)WaitingThreads->Remove();
+            Thread * ToWakeUp=WaitingThreads->Remove();
             scheduler->ReadyToRun(ToWakeUp); 
     }
     (void) interrupt->SetLevel(oldLevel);
@@ -160,7 +281,7 @@ void Condition::Broadcast(Lock* conditionLock) {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
     if(conditionLock->isHeldByCurrentThread()){
             while(!WaitingThreads->IsEmpty()){
-                    scheduler->ReadyToRun((Thread *)WaitingThreads->Remove());
+                    scheduler->ReadyToRun(WaitingThreads->Remove());
             }
     }
     (void) interrupt->SetLevel(oldLevel);
@@ -185,4 +306,126 @@ void Barrier::Wait(){
 Barrier::~Barrier(){
         delete cv;
         delete lock;
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock, so that it can be used for 
+//	synchronization.  The lock is initially FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char* debugName)
+{
+    name = debugName;
+    activeReaders = 0;
+    writing = FALSE;
+    readQueue = new IntrusiveList<Thread>;
+    writeQueue = new IntrusiveList<Thread>;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	De-allocate a reader-writer lock, when no longer needed.  Assume 
+//	no one holds it or is waiting for it!
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    delete readQueue;
+    delete writeQueue;
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadAcquire
+// 	Wait until no writer holds the lock, or is waiting for it, then
+//	share it with any other readers.  If we have to wait, whoever
+//	wakes us up has already counted us as a reader.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReadAcquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (writing || !writeQueue->IsEmpty()) {
+	DEBUG('s', "Reader %s waits for %s\n", currentThread->getName(), name);
+	readQueue->Append(currentThread);
+	currentThread->Sleep();
+    } else
+	activeReaders++;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadRelease
+// 	Stop reading.  If we were the last reader, hand the lock to the
+//	first waiting writer, if any.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReadRelease()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(activeReaders > 0);
+    activeReaders--;
+    if (activeReaders == 0 && !writeQueue->IsEmpty()) {
+	writing = TRUE;
+	scheduler->ReadyToRun(writeQueue->Remove());
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteAcquire
+// 	Wait until no one else holds the lock, then take it.  If we have
+//	to wait, whoever wakes us up has already given us the lock.
+//----------------------------------------------------------------------
+
+void
+RWLock::WriteAcquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (writing || activeReaders > 0) {
+	DEBUG('s', "Writer %s waits for %s\n", currentThread->getName(), name);
+	writeQueue->Append(currentThread);
+	currentThread->Sleep();
+    } else
+	writing = TRUE;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteRelease
+// 	Stop writing.  If readers queued up while we were writing, let
+//	all of them in at once; otherwise hand the lock to the next
+//	waiting writer, if any.
+//
+//	The readers are all counted before any of them is woken up:
+//	waking one may switch to it right away, and it must not find the
+//	lock free for a writer while the rest of the batch is still
+//	queued.
+//----------------------------------------------------------------------
+
+void
+RWLock::WriteRelease()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int batch = readQueue->NumInList();
+
+    ASSERT(writing);
+    if (batch > 0) {
+	writing = FALSE;
+	activeReaders += batch;
+	DEBUG('s', "Waking %d readers on %s\n", batch, name);
+	for (int i = 0; i < batch; i++)
+	    scheduler->ReadyToRun(readQueue->Remove());
+    } else if (!writeQueue->IsEmpty())
+	scheduler->ReadyToRun(writeQueue->Remove());	// still writing
+    else
+	writing = FALSE;
+    (void) interrupt->SetLevel(oldLevel);
+}
@@ -48,7 +48,8 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List *queue;       // threads waiting in P() for the value to be > 0
+    IntrusiveList<Thread> *queue; // threads waiting in P() for the value to be > 0,
+    		       // highest priority first
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -62,6 +63,13 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// Locks implement priority inheritance: while a thread waits in Acquire,
+// the owner (and, transitively, whoever the owner is waiting for) runs
+// with at least the waiter's priority, so that medium priority threads
+// cannot hold up a high priority thread by preempting the owner.  
+// The boost is undone in Release.  Waiters are woken highest priority
+// first.
 
 class Lock {
   public:
@@ -77,10 +85,23 @@ class Lock {
 					// checking in Release, and in
 					// Condition variable ops below.
 
+    Thread *getOwner() { return owner; }
+
   private:
     char* name;				// for debugging
-    Semaphore* mutex;                    // Provide basic synchronizing
-    int OwnerId;                        // who have acquired the lock
+    Thread *owner;                      // who has acquired the lock,
+                                        // NULL if FREE
+    IntrusiveList<Thread> *waiters;     // threads waiting in Acquire,
+                                        // highest priority first
+    Lock *nextHeld;                     // next lock held by our owner
+    int acquiredAt;                     // when owner acquired us (kept
+                                        // only with "-lt")
+
+    static void Donate(Thread *donor);  // boost the owners of the locks
+                                        // donor is blocked on
+    static void Recompute(Thread *thread);
+                                        // restore thread's priority after
+                                        // it gives up a lock
 };
 
 // The following class defines a "condition variable".  A condition
@@ -132,7 +153,7 @@ class Condition {
 
   private:
     char* name;
-    List*  WaitingThreads;
+    IntrusiveList<Thread> *WaitingThreads;	// highest priority first
 };
 
 class Barrier {
@@ -146,4 +167,39 @@ class Barrier {
                 Condition* cv;
                 Lock* lock;
 };
+// The following class defines a "reader-writer lock".  Any number of
+// readers may hold the lock at once, or else one writer:
+//
+//	ReadAcquire/ReadRelease -- share the lock with other readers
+//
+//	WriteAcquire/WriteRelease -- hold the lock alone
+//
+// Writers have preference: once a writer is waiting, new readers queue
+// up behind it, so a stream of readers cannot starve it.  In turn, when
+// a writer releases the lock, every reader that queued up meanwhile is
+// let in at once, before the next writer, so writers cannot starve
+// readers either.  Within each class, waiters are served first come,
+// first served.
+//
+// The lock is handed directly to the threads it wakes up, so a woken
+// thread never has to compete again for the lock it was waiting for.
+
+class RWLock {
+  public:
+    RWLock(char* debugName);		// initialize lock to be FREE
+    ~RWLock();				// deallocate lock
+    char* getName() { return name; }	// debugging assist
+
+    void ReadAcquire();			// these are all *atomic*
+    void ReadRelease();
+    void WriteAcquire();
+    void WriteRelease();
+
+  private:
+    char* name;				// for debugging
+    int activeReaders;			// readers holding the lock
+    bool writing;			// is a writer holding the lock?
+    IntrusiveList<Thread> *readQueue;	// readers waiting, in arrival order
+    IntrusiveList<Thread> *writeQueue;	// writers waiting, in arrival order
+};
 #endif // SYNCH_H
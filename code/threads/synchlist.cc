@@ -1,8 +1,9 @@
 // synchlist.cc
-//	Routines for synchronized access to a list.
+//	Routines for synchronized access to a list, and to a bounded
+//	channel.
 //
-//	Implemented by surrounding the List abstraction
-//	with synchronization routines.
+//	Implemented by surrounding the List abstraction (or a circular
+//	buffer) with synchronization routines.
 //
 // 	Implemented in "monitor"-style -- surround each procedure with a
 // 	lock acquire and release pair, using condition signal and wait for
@@ -96,3 +97,239 @@ SynchList::Mapcar(VoidFunctionPtr func)
     list->Mapcar(func);
     lock->Release(); 
 }
+
+//----------------------------------------------------------------------
+// SynchChannel::SynchChannel
+//	Allocate and initialize the data structures needed for a bounded
+//	channel, empty to start with.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"maxItems" is the most items the channel holds at once.
+//----------------------------------------------------------------------
+
+SynchChannel::SynchChannel(char *debugName, int maxItems)
+{
+    ASSERT(maxItems > 0);
+    name = debugName;
+    capacity = maxItems;
+    buffer = new void *[capacity];
+    head = count = 0;
+    numSenders = numReceivers = 0;
+    lock = new Lock("channel lock");
+    notFull = new Condition("channel not full cond");
+    notEmpty = new Condition("channel not empty cond");
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::~SynchChannel
+//	De-allocate the data structures created for a channel.  Any items
+//	still in it are the caller's to dispose of, with TryRecv, first.
+//----------------------------------------------------------------------
+
+SynchChannel::~SynchChannel()
+{
+    delete [] buffer;
+    delete lock;
+    delete notFull;
+    delete notEmpty;
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::Put, SynchChannel::Get
+//	Add an item at the end of the circular buffer, or take the one at
+//	the front.  The caller holds the lock, and has made sure there is
+//	room (for Put) or an item (for Get).
+//----------------------------------------------------------------------
+
+void
+SynchChannel::Put(void *item)
+{
+    ASSERT(item != NULL && count < capacity);
+    buffer[(head + count) % capacity] = item;
+    count++;
+}
+
+void *
+SynchChannel::Get()
+{
+    void *item;
+
+    ASSERT(count > 0);
+    item = buffer[head];
+    head = (head + 1) % capacity;
+    count--;
+    return item;
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::WakeReceivers, SynchChannel::WakeSenders
+//	Signal up to "n" of the threads waiting for items (or for room),
+//	one per item added (or removed) -- and none at all if no one is 
+//	waiting.  The caller holds the lock.
+//----------------------------------------------------------------------
+
+void
+SynchChannel::WakeReceivers(int n)
+{
+    for (n = min(n, numReceivers); n > 0; n--)
+	notEmpty->Signal(lock);
+}
+
+void
+SynchChannel::WakeSenders(int n)
+{
+    for (n = min(n, numSenders); n > 0; n--)
+	notFull->Signal(lock);
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::Send
+//	Add an item at the end of the channel, waiting until there is 
+//	room for it.  Wake up a receiver, if any is waiting.
+//
+//	"item" is the thing to send; it can be a pointer to anything
+//		but NULL.
+//----------------------------------------------------------------------
+
+void
+SynchChannel::Send(void *item)
+{
+    lock->Acquire();
+    while (count == capacity) {
+	DEBUG('s', "Channel %s full\n", name);
+	numSenders++;
+	notFull->Wait(lock);
+	numSenders--;
+    }
+    Put(item);
+    WakeReceivers(1);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::TrySend
+//	Add an item at the end of the channel, unless it is full.
+// Returns:
+//	TRUE if the item was added.
+//----------------------------------------------------------------------
+
+bool
+SynchChannel::TrySend(void *item)
+{
+    bool sent = FALSE;
+
+    lock->Acquire();
+    if (count < capacity) {
+	Put(item);
+	WakeReceivers(1);
+	sent = TRUE;
+    }
+    lock->Release();
+    return sent;
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::Recv
+//	Take the item at the front of the channel, waiting until there is
+//	one.  Wake up a sender, if any is waiting for room.
+// Returns:
+//	The item.
+//----------------------------------------------------------------------
+
+void *
+SynchChannel::Recv()
+{
+    void *item;
+
+    lock->Acquire();
+    while (count == 0) {
+	numReceivers++;
+	notEmpty->Wait(lock);
+	numReceivers--;
+    }
+    item = Get();
+    WakeSenders(1);
+    lock->Release();
+    return item;
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::TryRecv
+//	Take the item at the front of the channel, if there is one.
+// Returns:
+//	The item, or NULL if the channel is empty.
+//----------------------------------------------------------------------
+
+void *
+SynchChannel::TryRecv()
+{
+    void *item = NULL;
+
+    lock->Acquire();
+    if (count > 0) {
+	item = Get();
+	WakeSenders(1);
+    }
+    lock->Release();
+    return item;
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::SendBatch
+//	Send "n" items, in order.  Each time we hold the lock, put in as
+//	many as there is room for, then wake up one receiver per item; 
+//	wait for room only when the channel is full.
+//
+//	Items sent by other threads may end up between ours, if we have
+//	to wait.
+//----------------------------------------------------------------------
+
+void
+SynchChannel::SendBatch(void **items, int n)
+{
+    int sent = 0;
+
+    lock->Acquire();
+    while (sent < n) {
+	int batch;
+
+	while (count == capacity) {
+	    numSenders++;
+	    notFull->Wait(lock);
+	    numSenders--;
+	}
+	batch = min(n - sent, capacity - count);
+	for (int i = 0; i < batch; i++)
+	    Put(items[sent++]);
+	WakeReceivers(batch);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchChannel::RecvBatch
+//	Wait until the channel has at least one item, then take as many 
+//	as are there, up to "max", and wake up one sender per item taken.
+// Returns:
+//	The number of items put in "items" -- at least one.
+//----------------------------------------------------------------------
+
+int
+SynchChannel::RecvBatch(void **items, int max)
+{
+    int batch;
+
+    ASSERT(max > 0);
+    lock->Acquire();
+    while (count == 0) {
+	numReceivers++;
+	notEmpty->Wait(lock);
+	numReceivers--;
+    }
+    batch = min(max, count);
+    for (int i = 0; i < batch; i++)
+	items[i] = Get();
+    WakeSenders(batch);
+    lock->Release();
+    return batch;
+}
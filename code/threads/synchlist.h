@@ -1,8 +1,9 @@
 // synchlist.h 
-//	Data structures for synchronized access to a list.
+//	Data structures for synchronized access to a list, and to a 
+//	bounded channel.
 //
-//	Implemented by surrounding the List abstraction
-//	with synchronization routines.
+//	Implemented by surrounding the List abstraction (or a circular
+//	buffer) with synchronization routines.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -39,4 +40,56 @@ class SynchList {
     Condition *listEmpty;	// wait in Remove if the list is empty
 };
 
+// The following class defines a "synchronized channel" -- a bounded
+// queue between any number of producer and consumer threads:
+//	1. Threads trying to receive wait until an item is there;
+//	   threads trying to send wait until there is room for it.
+//	2. The batch operations move as many items as they can each 
+//	   time they hold the lock, rather than one at a time.
+//	3. Sleeping threads are only signalled when there are any.
+//
+// Items are pointers to anything, but may not be NULL.
+
+class SynchChannel {
+  public:
+    SynchChannel(char *debugName, int maxItems);
+				// initialize an empty channel with room
+				// for "maxItems" items
+    ~SynchChannel();		// de-allocate the channel
+
+    void Send(void *item);	// add an item at the end, waiting if 
+				// the channel is full
+    bool TrySend(void *item);	// add an item if there is room; 
+				// return FALSE if not
+    void *Recv();		// take the first item, waiting if the
+				// channel is empty
+    void *TryRecv();		// take the first item if there is one;
+				// return NULL if not
+
+    void SendBatch(void **items, int n);
+				// send "n" items, in order
+    int RecvBatch(void **items, int max);
+				// wait for at least one item, then take
+				// up to "max"; return how many
+
+    int NumItems() { return count; }	// items in the channel, right now
+
+  private:
+    char *name;			// for debugging
+    void **buffer;		// circular buffer of items
+    int capacity;		// size of the buffer
+    int head;			// index of the first item
+    int count;			// number of items in the buffer
+    int numSenders;		// threads waiting in Send, for room
+    int numReceivers;		// threads waiting in Recv, for items
+    Lock *lock;			// mutual exclusion for all of the above
+    Condition *notFull;		// wait here for room
+    Condition *notEmpty;	// wait here for items
+
+    void Put(void *item);	// add an item; there must be room
+    void *Get();		// take the first item; there must be one
+    void WakeReceivers(int n);	// signal up to "n" waiting receivers
+    void WakeSenders(int n);	// signal up to "n" waiting senders
+};
+
 #endif // SYNCHLIST_H
@@ -7,35 +7,43 @@
 
 #include "copyright.h"
 #include "system.h"
+#include "simdriver.h"
 
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
 
-Thread *currentThread;			// the thread we are running now
-Thread *threadToBeDestroyed;  		// the thread that just finished
-Scheduler *scheduler;			// the ready list
-Interrupt *interrupt;			// interrupt status
-Statistics *stats;			// performance metrics
-Timer *timer;				// the hardware timer device,
+HostThreadLocal Thread *currentThread;	// the thread we are running now
+HostThreadLocal Thread *threadToBeDestroyed;  // the thread that just finished
+HostThreadLocal Scheduler *scheduler;	// the ready list
+HostThreadLocal Interrupt *interrupt;	// interrupt status
+HostThreadLocal Statistics *stats;	// performance metrics
+HostThreadLocal Timer *timer;		// the hardware timer device,
 					// for invoking context switches
-bool *TidMap;                           // recording the tid usage
-int MinAvailableTid;                    // the minimum tid which is available
-List *PCBList;                          // the list of pointers to all PCBs
+HostThreadLocal Alarm *alarmClock;	// for threads sleeping until a
+					// given time
+HostThreadLocal ThreadTable *threadTable; // every thread, by tid
+HostThreadLocal int defaultStackSize;   // thread stack size, in words
+HostThreadLocal LatencyStats *latency;	// why threads wait, or NULL
+HostThreadLocal Tracer *tracer;		// timeline of events, or NULL
 #ifdef FILESYS_NEEDED
-FileSystem  *fileSystem;
+HostThreadLocal FileSystem  *fileSystem;
 #endif
 
 #ifdef FILESYS
-SynchDisk   *synchDisk;
+HostThreadLocal SynchDisk   *synchDisk;
 #endif
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
-Machine *machine;	// user program memory and registers
-PhysicalPageEntry* PhysicalPageTable;
+HostThreadLocal Machine *machine;	// user program memory and registers
+HostThreadLocal PhysicalPageEntry* PhysicalPageTable;
+HostThreadLocal FutexTable *futexTable;	// user threads sleeping on words
+					// of their memory
+HostThreadLocal Profiler *profiler;	// where user programs spend their
+					// time, or NULL
 #endif
 
 #ifdef NETWORK
-PostOffice *postOffice;
+HostThreadLocal PostOffice *postOffice;
 #endif
 
 
@@ -83,13 +91,31 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    bool tickless = FALSE;
+    bool measureLatency = FALSE;
+    char *traceFile = NULL;
+    int stackWords = StackSize;
 
     #ifdef USER_PROGRAM
         bool debugUserProg = FALSE;	// single step user program
+        char *profileFile = NULL;	// profile user programs
+        char *symbolFile = NULL;	// ... and name addresses from here
     #endif
     #ifdef FILESYS_NEEDED
         bool format = FALSE;	// format disk
     #endif
+    #ifdef FILESYS
+        int cacheSectors = DefaultCacheSectors;	// buffer cache size
+        CachePolicy cachePolicy = CacheLRU;	// ... and what it evicts
+        int flushAge = DefaultFlushAge;	// how long it may stay dirty
+        DiskSchedule diskSchedule = DiskCLOOK;	// order of disk requests
+        bool mapDisk = FALSE;		// mmap the DISK file
+        int diskTracks = DefaultNumTracks;	// geometry to format with
+        int diskSectorsPerTrack = DefaultSectorsPerTrack;
+        int numDisks = 1;		// disks in the volume
+        VolumeLayout volumeLayout = VolumeStripe;	// ... and how
+        char *diskName = "DISK";	// UNIX file holding the disk
+    #endif
     #ifdef NETWORK
         double rely = 1;		// network reliability
         int netname = 0;		// UNIX socket name
@@ -110,15 +136,72 @@ Initialize(int argc, char **argv)
                             // number generator
             randomYield = TRUE;
             argCount = 2;
+        } else if (!strcmp(*argv, "-tl")) {
+            tickless = TRUE;		// time slice only when needed
+        } else if (!strcmp(*argv, "-lt")) {
+            measureLatency = TRUE;	// histograms of waiting times
+        } else if (!strcmp(*argv, "-tr")) {
+            ASSERT(argc > 1);
+            traceFile = *(argv + 1);	// timeline of the simulation
+            argCount = 2;
+        } else if (!strcmp(*argv, "-ss")) {
+            ASSERT(argc > 1);
+            stackWords = atoi(*(argv + 1));	// thread stack size
+            ASSERT(stackWords > 0);
+            argCount = 2;
         }
         #ifdef USER_PROGRAM
             if (!strcmp(*argv, "-s"))
                 debugUserProg = TRUE;
+            else if (!strcmp(*argv, "-pf")) {
+                ASSERT(argc > 1);
+                profileFile = *(argv + 1);
+                argCount = 2;
+            } else if (!strcmp(*argv, "-ps")) {
+                ASSERT(argc > 1);
+                symbolFile = *(argv + 1);
+                argCount = 2;
+            }
         #endif
         #ifdef FILESYS_NEEDED
             if (!strcmp(*argv, "-f"))
                 format = TRUE;
         #endif
+        #ifdef FILESYS
+            if (!strcmp(*argv, "-cs")) {
+                ASSERT(argc > 1);
+                cacheSectors = atoi(*(argv + 1));
+                ASSERT(cacheSectors >= 0);
+                argCount = 2;
+            } else if (!strcmp(*argv, "-cr")) {
+                ASSERT(argc > 1);
+                cachePolicy = CachePolicyNamed(*(argv + 1));
+                argCount = 2;
+            } else if (!strcmp(*argv, "-fa")) {
+                ASSERT(argc > 1);
+                flushAge = atoi(*(argv + 1));
+                ASSERT(flushAge >= 0);
+                argCount = 2;
+            } else if (!strcmp(*argv, "-ds")) {
+                ASSERT(argc > 1);
+                diskSchedule = DiskScheduleNamed(*(argv + 1));
+                argCount = 2;
+            } else if (!strcmp(*argv, "-dm")) {
+                mapDisk = TRUE;
+            } else if (!strcmp(*argv, "-dg")) {
+                ASSERT(argc > 2);
+                diskTracks = atoi(*(argv + 1));
+                diskSectorsPerTrack = atoi(*(argv + 2));
+                ASSERT(diskTracks > 0 && diskSectorsPerTrack > 0);
+                argCount = 3;
+            } else if (!strcmp(*argv, "-dv")) {
+                ASSERT(argc > 2);
+                volumeLayout = VolumeLayoutNamed(*(argv + 1));
+                numDisks = atoi(*(argv + 2));
+                ASSERT(numDisks >= 1 && numDisks <= MaxDisks);
+                argCount = 3;
+            }
+        #endif
         #ifdef NETWORK
             if (!strcmp(*argv, "-l")) {
                 ASSERT(argc > 1);
@@ -133,16 +216,16 @@ Initialize(int argc, char **argv)
     }
 
     DebugInit(debugArgs);			// initialize DEBUG messages
-    TidMap = new bool[ThreadsNumLimit];         // initialize TidMap
-    for (int i=0;i<ThreadsNumLimit;i++)
-        TidMap[i]=false;
-
-    MinAvailableTid=0;                          // initialize MinAvailTid
-    PCBList = new List();                       // initialize PCB list
+    defaultStackSize = stackWords;
+    threadTable = new ThreadTable;		// no threads yet
     stats = new Statistics();			// collect statistics
+    latency = measureLatency ? new LatencyStats : NULL;
+    tracer = (traceFile != NULL) ? new Tracer(traceFile) : NULL;
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
-    if (randomYield)				// start the timer (if needed)
+    scheduler = new Scheduler(tickless, randomYield);
+						// initialize the ready queue
+    alarmClock = new Alarm();			// and the sleeping threads
+    if (randomYield && !tickless)		// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
     threadToBeDestroyed = NULL;
@@ -166,10 +249,18 @@ Initialize(int argc, char **argv)
 			PhysicalPageTable[i].valid=false;
 			PhysicalPageTable[i].dirty=false;
 		}
+	futexTable = new FutexTable;
+	profiler = (profileFile != NULL) ? 
+			new Profiler(profileFile, symbolFile) : NULL;
     #endif
 
     #ifdef FILESYS
-        synchDisk = new SynchDisk("DISK");
+	if (sweepJob != NULL)		// not shared with the other
+	    diskName = SweepDiskName();	// simulations of a sweep
+        synchDisk = new SynchDisk(diskName, cacheSectors, cachePolicy, 
+				  flushAge, diskSchedule, mapDisk,
+				  format ? diskTracks : 0, diskSectorsPerTrack,
+				  numDisks, volumeLayout);
     #endif
 
     #ifdef FILESYS_NEEDED
@@ -196,6 +287,8 @@ Cleanup()
     #ifdef USER_PROGRAM
         delete machine;
 	delete PhysicalPageTable;
+	delete futexTable;
+	delete profiler;
     #endif
 
     #ifdef FILESYS_NEEDED
@@ -203,15 +296,127 @@ Cleanup()
     #endif
 
     #ifdef FILESYS
+        if (synchDisk != NULL)
+            synchDisk->Flush();		// write back the buffer cache
         delete synchDisk;
     #endif
     
     delete timer;
+    delete alarmClock;
     delete scheduler;
     delete interrupt;
-    delete PCBList;
+    delete threadTable;
+    delete latency;
+    delete tracer;			// writes out the rest of the trace
+    FlushStackPool();
+    FlushSlabs();
 
-    
+    if (sweepJob != NULL)	// one of several simulations in this 
+	SweepJobDone();		// process; return to the sweep driver
     Exit(0);
 }
 
+//----------------------------------------------------------------------
+// SimContext::SimContext
+// 	Initialize an empty simulation context.
+//----------------------------------------------------------------------
+
+SimContext::SimContext()
+{
+    currentThread = threadToBeDestroyed = NULL;
+    scheduler = NULL;
+    interrupt = NULL;
+    stats = NULL;
+    timer = NULL;
+    alarmClock = NULL;
+    threadTable = NULL;
+    latency = NULL;
+    tracer = NULL;
+#ifdef USER_PROGRAM
+    machine = NULL;
+    PhysicalPageTable = NULL;
+    futexTable = NULL;
+    profiler = NULL;
+#endif
+#ifdef FILESYS_NEEDED
+    fileSystem = NULL;
+#endif
+#ifdef FILESYS
+    synchDisk = NULL;
+#endif
+#ifdef NETWORK
+    postOffice = NULL;
+#endif
+}
+
+//----------------------------------------------------------------------
+// SimContext::Save
+// 	Capture the simulated machine that the calling host thread
+//	is running.
+//----------------------------------------------------------------------
+
+void
+SimContext::Save()
+{
+    this->currentThread = ::currentThread;
+    this->threadToBeDestroyed = ::threadToBeDestroyed;
+    this->scheduler = ::scheduler;
+    this->interrupt = ::interrupt;
+    this->stats = ::stats;
+    this->timer = ::timer;
+    this->alarmClock = ::alarmClock;
+    this->threadTable = ::threadTable;
+    this->latency = ::latency;
+    this->tracer = ::tracer;
+#ifdef USER_PROGRAM
+    this->machine = ::machine;
+    this->PhysicalPageTable = ::PhysicalPageTable;
+    this->futexTable = ::futexTable;
+    this->profiler = ::profiler;
+#endif
+#ifdef FILESYS_NEEDED
+    this->fileSystem = ::fileSystem;
+#endif
+#ifdef FILESYS
+    this->synchDisk = ::synchDisk;
+#endif
+#ifdef NETWORK
+    this->postOffice = ::postOffice;
+#endif
+}
+
+//----------------------------------------------------------------------
+// SimContext::Restore
+// 	Make the saved machine the one the calling host thread runs.
+//----------------------------------------------------------------------
+
+void
+SimContext::Restore()
+{
+    ::currentThread = this->currentThread;
+    ::threadToBeDestroyed = this->threadToBeDestroyed;
+    ::scheduler = this->scheduler;
+    ::interrupt = this->interrupt;
+    ::stats = this->stats;
+    ::timer = this->timer;
+    ::alarmClock = this->alarmClock;
+    ::threadTable = this->threadTable;
+    ::latency = this->latency;
+    ::tracer = this->tracer;
+#ifdef USER_PROGRAM
+    ::machine = this->machine;
+    ::PhysicalPageTable = this->PhysicalPageTable;
+    ::futexTable = this->futexTable;
+    ::profiler = this->profiler;
+#endif
+#ifdef FILESYS_NEEDED
+    ::fileSystem = this->fileSystem;
+#endif
+#ifdef FILESYS
+    ::synchDisk = this->synchDisk;
+#endif
+#ifdef NETWORK
+    ::postOffice = this->postOffice;
+#endif
+}
+
@@ -15,6 +15,10 @@
 #include "stats.h"
 #include "timer.h"
 #include "list.h"
+#include "alarm.h"
+#include "threadtable.h"
+#include "latency.h"
+#include "trace.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -22,15 +26,25 @@ extern void Initialize(int argc, char **argv); 	// Initialization,
 extern void Cleanup();				// Cleanup, called when
 						// Nachos is done.
 
-extern Thread *currentThread;			// the thread holding the CPU
-extern Thread *threadToBeDestroyed;  		// the thread that just finished
-extern Scheduler *scheduler;			// the ready list
-extern Interrupt *interrupt;			// interrupt status
-extern Statistics *stats;			// performance metrics
-extern Timer *timer;				// the hardware alarm clock
-extern bool *TidMap;                          // recording the tid usage
-extern int MinAvailableTid;                     // the minimum tid which is available
-extern List *PCBList;                           // the list of pointers to all PCBs
+// Each of the following is private to the host thread running the
+// simulation, so that several independent simulated machines can run 
+// in one UNIX process (see simdriver.cc).  Within a simulation they
+// behave exactly like ordinary globals.
+
+extern HostThreadLocal Thread *currentThread;	// the thread holding the CPU
+extern HostThreadLocal Thread *threadToBeDestroyed;  // the thread that just finished
+extern HostThreadLocal Scheduler *scheduler;	// the ready list
+extern HostThreadLocal Interrupt *interrupt;	// interrupt status
+extern HostThreadLocal Statistics *stats;	// performance metrics
+extern HostThreadLocal Timer *timer;		// the hardware alarm clock
+extern HostThreadLocal Alarm *alarmClock;	// threads sleeping until
+						// a given time
+extern HostThreadLocal ThreadTable *threadTable; // every thread, by tid
+extern HostThreadLocal int defaultStackSize;    // thread stack size, in words
+extern HostThreadLocal LatencyStats *latency;	// why threads wait, or NULL
+						// if not measured ("-lt")
+extern HostThreadLocal Tracer *tracer;		// timeline of events, or NULL
+						// if not traced ("-tr")
 
 class PhysicalPageEntry{
 	public:
@@ -42,23 +56,70 @@ class PhysicalPageEntry{
 };
 #ifdef USER_PROGRAM
 #include "machine.h"
-extern Machine* machine;	// user program memory and registers
-extern PhysicalPageEntry* PhysicalPageTable;
+extern HostThreadLocal Machine* machine;	// user program memory and registers
+extern HostThreadLocal PhysicalPageEntry* PhysicalPageTable;
+#include "futex.h"
+extern HostThreadLocal FutexTable *futexTable;	// user threads sleeping on
+						// words of their memory
+#include "profile.h"
+extern HostThreadLocal Profiler *profiler;	// where user programs spend
+						// their time, or NULL ("-pf")
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
 #include "filesys.h"
-extern FileSystem  *fileSystem;
+extern HostThreadLocal FileSystem  *fileSystem;
 #endif
 
 #ifdef FILESYS
 #include "synchdisk.h"
-extern SynchDisk   *synchDisk;
+extern HostThreadLocal SynchDisk   *synchDisk;
 #endif
 
 #ifdef NETWORK
 #include "post.h"
-extern PostOffice* postOffice;
+extern HostThreadLocal PostOffice* postOffice;
+#endif
+
+// The following class bundles the global state of one simulated
+// machine.  Save() captures the machine the calling host thread 
+// is currently running; Restore() makes a saved machine current
+// again.  The sweep driver (simdriver.cc) saves each machine right 
+// after Initialize, and reads its statistics -- the only part Cleanup 
+// does not de-allocate -- once it has halted.
+
+class SimContext {
+  public:
+    SimContext();			// an empty context
+    
+    void Save();			// capture this host thread's machine
+    void Restore();			// install into this host thread
+
+    Thread *currentThread;
+    Thread *threadToBeDestroyed;
+    Scheduler *scheduler;
+    Interrupt *interrupt;
+    Statistics *stats;
+    Timer *timer;
+    Alarm *alarmClock;
+    ThreadTable *threadTable;
+    LatencyStats *latency;
+    Tracer *tracer;
+#ifdef USER_PROGRAM
+    Machine *machine;
+    PhysicalPageEntry *PhysicalPageTable;
+    FutexTable *futexTable;
+    Profiler *profiler;
 #endif
+#ifdef FILESYS_NEEDED
+    FileSystem *fileSystem;
+#endif
+#ifdef FILESYS
+    SynchDisk *synchDisk;
+#endif
+#ifdef NETWORK
+    PostOffice *postOffice;
+#endif
+};
 
 #endif // SYSTEM_H
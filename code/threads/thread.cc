@@ -24,38 +24,99 @@
 					// execution stack, for detecting 
 					// stack overflows
 
+// Stacks given up by finished threads, kept to be reused by threads
+// forked later, rather than de-allocated and allocated afresh.
+// Stacks of any size may be kept; a new thread takes one of its size.
+
+static HostThreadLocal int *stackPool[StackPoolLimit];
+static HostThreadLocal int stackPoolSize[StackPoolLimit];
+static HostThreadLocal int stackPoolCount = 0;
+
+//----------------------------------------------------------------------
+// AllocStack
+// 	Return a stack of "size" words, from the pool if there is one
+//	there, otherwise freshly allocated (with guard pages on either
+//	side).  The most recently freed stack is preferred, as it is the
+//	most likely to still be in the host's cache.
+//----------------------------------------------------------------------
+
+static int *
+AllocStack(int size)
+{
+    for (int i = stackPoolCount - 1; i >= 0; i--)
+	if (stackPoolSize[i] == size) {
+	    int *stack = stackPool[i];
+
+	    stackPoolCount--;
+	    stackPool[i] = stackPool[stackPoolCount];
+	    stackPoolSize[i] = stackPoolSize[stackPoolCount];
+	    return stack;
+	}
+    return (int *) AllocBoundedArray(size * sizeof(int));
+}
+
+//----------------------------------------------------------------------
+// FreeStack
+// 	Give back a stack of "size" words: keep it in the pool, unless
+//	the pool is full.
+//----------------------------------------------------------------------
+
+static void
+FreeStack(int *stack, int size)
+{
+    if (stackPoolCount < StackPoolLimit) {
+	stackPool[stackPoolCount] = stack;
+	stackPoolSize[stackPoolCount] = size;
+	stackPoolCount++;
+    } else
+	DeallocBoundedArray((char *) stack, size * sizeof(int));
+}
+
+//----------------------------------------------------------------------
+// FlushStackPool
+// 	De-allocate all of the stacks kept for reuse.
+//----------------------------------------------------------------------
+
+void
+FlushStackPool()
+{
+    while (stackPoolCount > 0) {
+	stackPoolCount--;
+	DeallocBoundedArray((char *) stackPool[stackPoolCount], 
+		stackPoolSize[stackPoolCount] * sizeof(int));
+    }
+}
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
 //	Thread::Fork.
 //
 //	"threadName" is an arbitrary string, useful for debugging.
+//	"prio" is the scheduling priority (smaller is more urgent).
+//	"stackWords" is the size of the thread's stack, in words;
+//		0 means the default size (see "-ss").
 //----------------------------------------------------------------------
 
-Thread::Thread(char* threadName,int prio=127)
+Thread::Thread(char* threadName,int prio,int stackWords)
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
-        ASSERT(MinAvailableTid>=0&&MinAvailableTid<ThreadsNumLimit);
-        ASSERT(TidMap[MinAvailableTid]!=true)
-        tid=MinAvailableTid;
+        tid=threadTable->Add(this);
         uid=0;
-        TidMap[tid]=true;
-        for(int i=tid+1;i<ThreadsNumLimit;i++){
-                if(!TidMap[i])
-                        MinAvailableTid=i;
-                        break;
-        }
-        if(MinAvailableTid==tid)
-                MinAvailableTid=ThreadsNumLimit;
-        PCBList->SortedInsert(this,tid);
     (void) interrupt->SetLevel(oldLevel);
-    priority=prio;
+    priority=basePriority=prio;
+    heldLocks=NULL;
+    waitingFor=NULL;
+    readySince=-1;
+    readyTicks=blockedTicks=0;
     name = threadName;
     stackTop = NULL;
     stack = NULL;
+    stackSize = (stackWords > 0) ? stackWords : defaultStackSize;
     status = JUST_CREATED;
 #ifdef USER_PROGRAM
     space = NULL;
+    profile = NULL;
 #endif
 }
 
@@ -88,15 +149,19 @@ Thread::~Thread()
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
-        PCBList->Remove(this);
-        ASSERT(TidMap[tid]==true);
-        TidMap[tid]=false;
-        MinAvailableTid=min(tid,MinAvailableTid);
+        threadTable->Remove(tid);
     (void) interrupt->SetLevel(oldLevel);
 
     ASSERT(this != currentThread);
-    if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+    if (latency != NULL)
+	latency->ThreadDone(this);
+#ifdef USER_PROGRAM
+    delete profile;
+#endif
+    if (stack != NULL) {
+	CheckOverflow();		// don't recycle a trampled stack
+	FreeStack(stack, stackSize);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -153,7 +218,7 @@ Thread::CheckOverflow()
 {
     if (stack != NULL)
 #ifdef HOST_SNAKE			// Stacks grow upward on the Snakes
-	ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
+	ASSERT(stack[stackSize - 1] == STACK_FENCEPOST);
 #else
 	ASSERT((int) *stack == (int) STACK_FENCEPOST);
 #endif
@@ -276,7 +341,7 @@ void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 //      to every item in the PCBlist
 //----------------------------------------------------------------------
 void ThreadShow(){
-        PCBList->Mapcar(ThreadPrint);
+        threadTable->Apply(ThreadPrint);
 }
 //----------------------------------------------------------------------
 // Thread::StackAllocate
@@ -293,19 +358,20 @@ void ThreadShow(){
 void
 Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = AllocStack(stackSize);	// the fencepost is re-stamped
+					// below, if the stack is reused
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
     stackTop = stack + 16;	// HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
+    stack[stackSize - 1] = STACK_FENCEPOST;
 #else
     // i386 & MIPS & SPARC stack works from high addresses to low addresses
 #ifdef HOST_SPARC
     // SPARC stack must contains at least 1 activation record to start with.
-    stackTop = stack + StackSize - 96;
+    stackTop = stack + stackSize - 96;
 #else  // HOST_MIPS  || HOST_i386
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;	// -4 to be on the safe side!
 #ifdef HOST_i386
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
@@ -355,5 +421,6 @@ Thread::RestoreUserState()
 {
     for (int i = 0; i < NumTotalRegs; i++)
 	machine->WriteRegister(i, userRegisters[i]);
+    machine->llBit = FALSE;	// other threads may have run since our LL
 }
 #endif
@@ -24,7 +24,8 @@
 //	that your thread stacks are too small.)
 //	
 //	One thing to try if you find yourself with seg faults is to
-//	increase the size of thread stack -- ThreadStackSize.
+//	increase the size of thread stack -- StackSize, or the "-ss"
+//	flag, or the stack size given to the Thread constructor.
 //
 //  	In this interface, forking a thread takes two steps.
 //	We must first allocate a data structure for it: "t = new Thread".
@@ -39,6 +40,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "ilist.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -51,21 +53,28 @@
 #define MachineStateSize 18 
 
 
-// Size of the thread's private execution stack.
+// Default size of the thread's private execution stack; may be
+// changed with "-ss", or per thread.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 #define StackSize	(4 * 1024)	// in words
 
-#define ThreadsNumLimit 128             // the max num of threads
+#define StackPoolLimit	64		// max # of stacks kept for reuse
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
 
+class Lock;
+class ProfileState;
+
 // external function, dummy routine whose sole job is to call Thread::Print
 extern void ThreadPrint(int arg);	 
 
 // external function, whose job is to implemnt ThreadShow
 extern void ThreadShow();
 
+// external function, to give back the stacks kept for reuse
+extern void FlushStackPool();
+
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
 //
@@ -85,7 +94,11 @@ class Thread {
     void *machineState[MachineStateSize];  // all registers except for stackTop
 
   public:
-    Thread(char* debugName,int prio=127);		// initialize a Thread 
+    Thread(char* debugName,int prio=127,int stackWords=0);
+    					// initialize a Thread; its stack
+					// is allocated in Fork, with 
+					// "stackWords" words (0 for the
+					// default size)
     ~Thread(); 				// deallocate a Thread
 					// NOTE -- thread being deleted
 					// must not be running when delete 
@@ -108,7 +121,8 @@ class Thread {
     int getUid(){return uid;}
     int getTid(){return tid;}
     int getPriority(){return priority;}
-    int setPriority(int prio){priority=prio;}
+    void setPriority(int prio){basePriority=priority=prio;}
+    int getBasePriority(){return basePriority;}
     ThreadStatus getStatus(){return status;}
 
     // some of the private data for this class is listed above
@@ -116,11 +130,26 @@ class Thread {
     int* stack; 	 		// Bottom of the stack 
 					// NULL if this is the main thread
 					// (If NULL, don't deallocate stack)
+    int stackSize;			// size of the stack, in words
     ThreadStatus status;		// ready, running or blocked
     char* name;
     int uid;                            // user id 
     int tid;                            // thread id 
-    int priority;                       // priority when scheduling
+    int priority;                       // priority when scheduling,
+                                        // including any boost inherited
+                                        // from threads waiting on our locks
+    int basePriority;                   // priority before inheritance
+    Lock *heldLocks;                    // locks we hold, chained through
+                                        // Lock::nextHeld
+    Lock *waitingFor;                   // lock we are blocked on, if any
+    IntrusiveLink<Thread> link;         // our place on the ready list, or
+                                        // on the wait queue we are
+                                        // blocked on
+    int readySince;                     // when we were last made ready,
+                                        // or -1 (kept only with "-lt")
+    int readyTicks;                     // total time spent ready
+    int blockedTicks;                   // total time spent blocked on
+                                        // synchronization primitives
 
     void StackAllocate(VoidFunctionPtr func, void *arg);
     					// Allocate a stack for thread.
@@ -138,6 +167,8 @@ class Thread {
     void RestoreUserState();		// restore user-level register state
 
     AddrSpace *space;			// User code this thread is running.
+    ProfileState *profile;		// the profiler's record of where we
+					// are, or NULL (see profile.h)
 #endif
 };
 
@@ -0,0 +1,160 @@
+// threadtable.cc 
+//	Routines to manage the table of all threads by id.
+//
+//	The caller is responsible for mutual exclusion; Thread's 
+//	constructor and destructor disable interrupts around their use
+//	of the table.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadtable.h"
+#include "thread.h"
+
+#include <strings.h>			// for ffs
+
+#define AllOnes		(~0u)
+
+//----------------------------------------------------------------------
+// ThreadTable::ThreadTable
+// 	Initialize an empty table, with room for InitialTids ids.
+//----------------------------------------------------------------------
+
+ThreadTable::ThreadTable()
+{
+    capacity = InitialTids;
+    threads = new Thread *[capacity];
+    used = new unsigned int[capacity / TidsPerWord];
+    full = new unsigned int[capacity / (TidsPerWord * TidsPerWord)];
+    for (int i = 0; i < capacity; i++)
+	threads[i] = NULL;
+    for (int i = 0; i < capacity / TidsPerWord; i++)
+	used[i] = 0;
+    for (int i = 0; i < capacity / (TidsPerWord * TidsPerWord); i++)
+	full[i] = 0;
+    numThreads = 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::~ThreadTable
+// 	De-allocate the table.  The threads themselves are not touched.
+//----------------------------------------------------------------------
+
+ThreadTable::~ThreadTable()
+{
+    delete [] threads;
+    delete [] used;
+    delete [] full;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Grow
+// 	Double the number of ids there is room for.  The capacity is
+//	always a multiple of TidsPerWord * TidsPerWord, so that "full"
+//	is a whole number of words.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Grow()
+{
+    int newCapacity = capacity * 2;
+    Thread **newThreads = new Thread *[newCapacity];
+    unsigned int *newUsed = new unsigned int[newCapacity / TidsPerWord];
+    unsigned int *newFull = 
+	new unsigned int[newCapacity / (TidsPerWord * TidsPerWord)];
+    int i;
+
+    for (i = 0; i < newCapacity; i++)
+	newThreads[i] = (i < capacity) ? threads[i] : NULL;
+    for (i = 0; i < newCapacity / TidsPerWord; i++)
+	newUsed[i] = (i < capacity / TidsPerWord) ? used[i] : 0;
+    for (i = 0; i < newCapacity / (TidsPerWord * TidsPerWord); i++)
+	newFull[i] = (i < capacity / (TidsPerWord * TidsPerWord)) ? full[i] : 0;
+
+    delete [] threads;
+    delete [] used;
+    delete [] full;
+    threads = newThreads;
+    used = newUsed;
+    full = newFull;
+    DEBUG('t', "Thread table grown from %d to %d ids\n", capacity, 
+	newCapacity);
+    capacity = newCapacity;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Add
+// 	Find the lowest free id, mark it in use, record "thread" under
+//	it, and return it.  Grows the table if every id is in use.
+//----------------------------------------------------------------------
+
+int
+ThreadTable::Add(Thread *thread)
+{
+    int numFull = capacity / (TidsPerWord * TidsPerWord);
+    int f, w, tid;
+
+    for (f = 0; f < numFull && full[f] == AllOnes; f++)
+	;
+    if (f == numFull)			// every id is taken
+	Grow();
+    w = f * TidsPerWord + ffs(~full[f]) - 1;	// a word with a free bit
+    tid = w * TidsPerWord + ffs(~used[w]) - 1;	// and the bit
+
+    used[w] |= 1u << (tid % TidsPerWord);
+    if (used[w] == AllOnes)
+	full[f] |= 1u << (w % TidsPerWord);
+    threads[tid] = thread;
+    numThreads++;
+    return tid;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Remove
+// 	Free an id, so that it may be given to another thread.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Remove(int tid)
+{
+    int w = tid / TidsPerWord;
+
+    ASSERT(Lookup(tid) != NULL);
+    used[w] &= ~(1u << (tid % TidsPerWord));
+    full[w / TidsPerWord] &= ~(1u << (w % TidsPerWord));
+    threads[tid] = NULL;
+    numThreads--;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Lookup
+// 	Return the thread with id "tid", or NULL if the id is not in use.
+//----------------------------------------------------------------------
+
+Thread *
+ThreadTable::Lookup(int tid)
+{
+    if (tid < 0 || tid >= capacity)
+	return NULL;
+    return threads[tid];
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Apply
+// 	Call "func" on every thread in the table, lowest id first.  
+//	Words of the bitmap with no id in use are skipped.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Apply(VoidFunctionPtr func)
+{
+    for (int w = 0; w < capacity / TidsPerWord; w++) {
+	if (used[w] == 0)
+	    continue;
+	for (int tid = w * TidsPerWord; tid < (w + 1) * TidsPerWord; tid++)
+	    if (threads[tid] != NULL)
+		(*func)((int) threads[tid]);
+    }
+}
@@ -0,0 +1,56 @@
+// threadtable.h 
+//	Data structures for assigning thread ids, and for finding a
+//	thread by its id.
+//
+//	Thread ids are handed out lowest-free-first, from a bitmap that
+//	grows as needed, so there is no fixed limit on the number of 
+//	threads.  A second, summary bitmap records which words of the
+//	first are full, so a free id is found by looking at one summary
+//	word per 1024 ids, rather than at every id.  Each thread is
+//	recorded in an array indexed by id, which grows along with the 
+//	bitmaps.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+
+#define TidsPerWord	32		// bits in an unsigned int
+#define InitialTids	(TidsPerWord * TidsPerWord)
+					// ids to make room for at first
+
+// The following class defines the table of all threads, by id.
+
+class ThreadTable {
+  public:
+    ThreadTable();			// initialize an empty table
+    ~ThreadTable();			// de-allocate the table
+
+    int Add(Thread *thread);		// give thread the lowest free id,
+					// and return it
+    void Remove(int tid);		// free an id
+    Thread *Lookup(int tid);		// the thread with this id, or NULL
+    int NumThreads() { return numThreads; }
+
+    void Apply(VoidFunctionPtr func);	// call func((int) thread) for 
+					// every thread, in order of id
+
+  private:
+    int capacity;			// # of ids there is room for
+    Thread **threads;			// the thread with each id
+    unsigned int *used;			// bit set if an id is in use
+    unsigned int *full;			// bit set if a word of "used" is
+					// all ones
+    int numThreads;			// # of ids in use
+
+    void Grow();			// double the capacity
+};
+
+#endif // THREADTABLE_H
@@ -13,9 +13,12 @@
 #include "system.h"
 #include "elevatortest.h"
 #include "synch.h"
+#include "synchlist.h"
 
-// testnum is set in main.cc
-int testnum = 1;
+// testnum is set in main.cc.  The state of the tests is private to
+// the host thread, like the rest of the simulation, so that the tests can
+// run side by side in a sweep (see simdriver.h).
+HostThreadLocal int testnum = 1;
 
 //----------------------------------------------------------------------
 // SimpleThread
@@ -57,24 +60,51 @@ ThreadTest1()
 
 //----------------------------------------------------------------------
 // ThreadTest2
-// 	create ThreadNumLimit +1 process
+// 	create many more threads than the thread table starts out with
+//      (and far more than the old limit of 128), free some ids and 
+//      check that exactly those are given out again, lowest first
 //----------------------------------------------------------------------
+#define ManyThreads     5000
 void ThreadTest2(){
     DEBUG('t', "Entering ThreadTest2");
-    for(int i=0;i<=ThreadsNumLimit;i++){
-            Thread *t=new Thread("forked thread in test 2");
-            t->Print();
+    Thread **t=new Thread*[ManyThreads];
+    int *freed=new int[ManyThreads];
+    int numFreed=0;
+    int before=threadTable->NumThreads();
+    for(int i=0;i<ManyThreads;i++){
+            t[i]=new Thread("forked thread in test 2");
+            ASSERT(i==0||t[i]->getTid()>t[i-1]->getTid());
     }
+    t[ManyThreads-1]->Print();
+    ASSERT(threadTable->NumThreads()==before+ManyThreads);
+    ASSERT(t[ManyThreads-1]->getTid()>=InitialTids);   // the table grew
+    for(int i=0;i<ManyThreads;i+=3){
+            int tid=t[i]->getTid();
+            delete t[i];
+            ASSERT(threadTable->Lookup(tid)==NULL);
+            freed[numFreed++]=tid;              // in increasing order
+    }
+    ASSERT(threadTable->NumThreads()==before+ManyThreads-numFreed);
+    for(int i=0,k=0;i<ManyThreads;i+=3,k++){
+            t[i]=new Thread("reused id in test 2");
+            ASSERT(t[i]->getTid()==freed[k]);
+            ASSERT(threadTable->Lookup(t[i]->getTid())==t[i]);
+    }
+    printf("%d threads\n",threadTable->NumThreads());
+    ASSERT(threadTable->NumThreads()==before+ManyThreads);
+    for(int i=0;i<ManyThreads;i++)
+            delete t[i];
+    delete [] t;
+    delete [] freed;
 }
 
-
 //----------------------------------------------------------------------
 // ThreadTest3
 // 	print out all of the threads
 //----------------------------------------------------------------------
 void ThreadTest3(){
     DEBUG('t', "Entering ThreadTest3");
-    for (int i=0;i<ThreadsNumLimit/2;i++){
+    for (int i=0;i<64;i++){
             Thread *t =new Thread("thread");
     }
     ThreadShow();
@@ -117,26 +147,26 @@ void ThreadTest4(){
 //----------------------------------------------------------------------
 // Reader writer problem using Semaphore
 //----------------------------------------------------------------------
-Semaphore mutex=Semaphore("mutex for reader counter",1);
-Semaphore db=Semaphore("mutex for DataBase",1);
-int ReaderCnt=0;
+HostThreadLocal Semaphore* mutex;
+HostThreadLocal Semaphore* db;
+HostThreadLocal int ReaderCnt=0;
 void reader(int a){
         while(1){
                 printf("%s tries to read\n",currentThread->getName());
                 interrupt->OneTick();
-                mutex.P();
+                mutex->P();
                 ReaderCnt++;
                 if(ReaderCnt==1)
-                        db.P();
-                mutex.V();
+                        db->P();
+                mutex->V();
                 printf("%s is reading\n",currentThread->getName());
                 interrupt->OneTick();
 
-                mutex.P();
+                mutex->P();
                 ReaderCnt--;
                 if(ReaderCnt==0)
-                        db.V();
-                mutex.V();
+                        db->V();
+                mutex->V();
                 printf("%s finished reading\n",currentThread->getName());
         }
 }
@@ -144,14 +174,16 @@ void writer(int a){
         while(1){
                 interrupt->OneTick();
                 printf("%s tries to write\n",currentThread->getName());
-                db.P();
+                db->P();
                 printf("%s is writing\n",currentThread->getName());
-                db.V();
+                db->V();
                 printf("%s finished writing\n",currentThread->getName());
         }
 }
 void ThreadTest5(){
         DEBUG('t', "Entering ThreadTest5\n");
+        mutex=new Semaphore("mutex for reader counter",1);
+        db=new Semaphore("mutex for DataBase",1);
         Thread* w1=new Thread("writer 0");
         Thread* r1=new Thread("Reader 1");
         Thread* r2=new Thread("Reader 2");
@@ -171,39 +203,39 @@ void ThreadTest5(){
 // Reader writer problem using Condition
 //----------------------------------------------------------------------
 
-int ActiveWriter=0;
-int ActiveReader=0;
-int WaitingWriter=0;
-int WaitingReader=0;
-Lock CntLock=Lock("Lock for reader-writer problem");
-Condition ReadCV=Condition("Read");
-Condition WriteCV=Condition("Write");
+HostThreadLocal int ActiveWriter=0;
+HostThreadLocal int ActiveReader=0;
+HostThreadLocal int WaitingWriter=0;
+HostThreadLocal int WaitingReader=0;
+HostThreadLocal Lock* CntLock;
+HostThreadLocal Condition* ReadCV;
+HostThreadLocal Condition* WriteCV;
 void CWriter(int a){
         while(1){
                 interrupt->OneTick();
                 printf("%s tries to write\n",currentThread->getName());
-                CntLock.Acquire();
+                CntLock->Acquire();
                 //Whenever there is a Reader reading or waiting to read
                 // the writer shall wait
                 while(ActiveReader>0||WaitingReader>0){
                         WaitingWriter++;
-                        WriteCV.Wait(&CntLock);
+                        WriteCV->Wait(CntLock);
                         WaitingWriter--;
                 }
                 ActiveWriter++;
-                CntLock.Release();
+                CntLock->Release();
                 printf("%s is Writing\n!",currentThread->getName());
-                CntLock.Acquire();
+                CntLock->Acquire();
                 ActiveWriter--;
                 //if there is Reader waiting,wake up them all
                 if(WaitingReader>0)
-                        ReadCV.Broadcast(&CntLock);
+                        ReadCV->Broadcast(CntLock);
                 //if no Reader is reading or waiting to read 
                 // Let a writer to write
                 else if (ActiveReader==0&&WaitingWriter>0){
-                        WriteCV.Signal(&CntLock);
+                        WriteCV->Signal(CntLock);
                 }
-                CntLock.Release();
+                CntLock->Release();
                 printf("%s finished writing\n",currentThread->getName());
         }
 }
@@ -211,31 +243,34 @@ void CReader(int a){
         while(1){
                 interrupt->OneTick();
                 printf("%s tries to read\n",currentThread->getName());
-                CntLock.Acquire();//获取锁
+                CntLock->Acquire();//获取锁
                 //When there is a writer writing ,wait
                 if(ActiveWriter>0){
                         WaitingReader++;//等待计数器自增
-                        ReadCV.Wait(&CntLock);//先放弃锁，然后睡眠，然后被唤醒，获取锁
+                        ReadCV->Wait(CntLock);//先放弃锁，然后睡眠，然后被唤醒，获取锁
                         WaitingReader--;//等待计数器自减
                 }
                 ActiveReader++;
-                CntLock.Release();
+                CntLock->Release();
                 printf("%s is Reading\n",currentThread->getName());
                 interrupt->OneTick();
 
-                CntLock.Acquire();
+                CntLock->Acquire();
                 ActiveReader--;
                 //if there is any Reader waiting ,wake up them all
                 if(WaitingReader>0)
-                        ReadCV.Broadcast(&CntLock);
+                        ReadCV->Broadcast(CntLock);
                 else if (ActiveReader==0&&WaitingWriter>0)
-                        WriteCV.Signal(&CntLock);
-                CntLock.Release();
+                        WriteCV->Signal(CntLock);
+                CntLock->Release();
                 printf("%s finished reading\n",currentThread->getName());
         }
 }
 void ThreadTest6(){
         DEBUG('t', "Entering ThreadTest6\n");
+        CntLock=new Lock("Lock for reader-writer problem");
+        ReadCV=new Condition("Read");
+        WriteCV=new Condition("Write");
         Thread* r1=new Thread("Reader 1");
         Thread* r2=new Thread("Reader 2");
         Thread* r3=new Thread("Reader 3");
@@ -257,7 +292,7 @@ void ThreadTest6(){
 // ThreadTest7
 // 	Test routine for Barrier
 //----------------------------------------------------------------------
-Barrier* ba;
+HostThreadLocal Barrier* ba;
 void BarrierTest(int a){
         while(1){
                 printf("%s has arrived at the barrier\n",currentThread->getName());
@@ -277,6 +312,304 @@ void ThreadTest7(){
         t2->Fork(BarrierTest,(void *)1);
         t3->Fork(BarrierTest,(void *)1);
 }
+
+//----------------------------------------------------------------------
+// ThreadTest8
+//      Tail latency of a high priority thread blocked on a lock held
+//      by a low priority thread, while a medium priority thread is
+//      ready to run.  Without priority inheritance the medium thread
+//      preempts the owner, and the high priority thread waits for
+//      the medium thread's whole burst; with it, the wait is bounded
+//      by the owner's critical section.
+//
+//      Then a boosted owner waits on a condition: releasing the lock
+//      drops its priority and wakes the high priority thread, which
+//      signals the condition at once.  The owner must come back from
+//      Wait once, and only after the signal.
+//----------------------------------------------------------------------
+#define PIRounds        20      // # of times to run the scenario
+#define PIBurst         50      // medium thread's burst, in ticks/10
+
+HostThreadLocal Lock* PILock;
+HostThreadLocal int PIWait[PIRounds];   // high priority thread's wait, per round
+HostThreadLocal int PIRound;            // current round
+HostThreadLocal int PIWork;             // length of this round's critical section
+HostThreadLocal Condition* PICondition;
+HostThreadLocal bool PISignalled;       // has the condition been signalled?
+HostThreadLocal int PIWakeups;          // # of returns from Wait
+
+// Consume "n" system ticks' worth of CPU time
+void PISpin(int n){
+        for(int i=0;i<n;i++){
+                interrupt->SetLevel(IntOff);
+                interrupt->SetLevel(IntOn);
+        }
+}
+void PIHigh(int a){
+        int start=stats->totalTicks;
+        PILock->Acquire();
+        PIWait[PIRound]=stats->totalTicks-start;
+        PILock->Release();
+}
+void PIMedium(int a){
+        PISpin(PIBurst);
+}
+void PILow(int a){
+        PILock->Acquire();
+        Thread* high=new Thread("high",10);
+        high->Fork(PIHigh,(void*)0);    // runs at once, and blocks on us
+        Thread* medium=new Thread("medium",20);
+        medium->Fork(PIMedium,(void*)0);
+        PISpin(PIWork);                 // critical section
+        PILock->Release();
+}
+void PISignaller(int a){
+        PILock->Acquire();              // lends our priority to the waiter
+        PISignalled=TRUE;
+        PICondition->Signal(PILock);
+        PILock->Release();
+}
+void PIWaiter(int a){
+        PILock->Acquire();
+        Thread* high=new Thread("signaller",10);
+        high->Fork(PISignaller,(void*)0);       // runs at once, and blocks on us
+        ASSERT(currentThread->getPriority()==10);
+        PICondition->Wait(PILock);      // Release wakes the signaller
+        ASSERT(PISignalled);
+        PIWakeups++;
+        PILock->Release();
+}
+void ThreadTest8(){
+        DEBUG('t', "Entering ThreadTest8\n");
+        int oldPriority=currentThread->getPriority();
+        int worst=0,total=0;
+
+        PILock=new Lock("Lock for priority inheritance test");
+        // let every thread of a round run to completion before we do
+        currentThread->setPriority(200);
+        for(PIRound=0;PIRound<PIRounds;PIRound++){
+                PIWork=1+Random()%(PIBurst/5);
+                Thread* low=new Thread("low",30);
+                low->Fork(PILow,(void*)0);
+                ASSERT(PIWait[PIRound]<=(PIWork+PIBurst/5)*SystemTick);
+                worst=max(worst,PIWait[PIRound]);
+                total+=PIWait[PIRound];
+        }
+
+        PICondition=new Condition("Condition for priority inheritance test");
+        PISignalled=FALSE;
+        PIWakeups=0;
+        Thread* waiter=new Thread("waiter",30);
+        waiter->Fork(PIWaiter,(void*)0);
+        ASSERT(PIWakeups==1);
+        currentThread->setPriority(oldPriority);
+        printf("High priority wait over %d rounds: mean %d, max %d ticks "
+                        "(medium burst %d ticks)\n",PIRounds,total/PIRounds,
+                        worst,PIBurst*SystemTick);
+}
+//----------------------------------------------------------------------
+// ThreadTest9
+//      Test routine for the alarm clock.  Threads sleep for lengths
+//      spread over several levels of the timer wheel, some of them
+//      for the same length, and one for longer than the wheel spans.
+//      Each must wake up no earlier than asked, and no more than
+//      SleepSlack ticks late; and they must wake in the order of
+//      their wakeup times, ties in the order they went to sleep.
+//----------------------------------------------------------------------
+int SleepLength[]={ 5, 63, 64, 100, 100, 4095, 4096, 300000, 1,
+                AlarmRange + 1000 };
+#define NumSleepers     ((int)(sizeof(SleepLength)/sizeof(int)))
+#define SleepSlack      (TimerTicks * 2)        // the woken threads
+                                        // ahead of us run only briefly
+
+HostThreadLocal int LastWakeup;         // wakeup time of the last
+HostThreadLocal int LastSleeper;        // sleeper to wake, and its number
+HostThreadLocal int SleepersWoken;
+
+void Sleeper(int which){
+        int start=stats->totalTicks;
+        int wakeup=start+SleepLength[which];
+        alarmClock->Pause(SleepLength[which]);
+        printf("%s slept %d ticks, asked for %d\n",currentThread->getName(),
+                        stats->totalTicks-start,SleepLength[which]);
+        ASSERT(stats->totalTicks>=wakeup);
+        ASSERT(stats->totalTicks-wakeup<=SleepSlack);
+        ASSERT(wakeup>LastWakeup||(wakeup==LastWakeup&&which>LastSleeper));
+        LastWakeup=wakeup;
+        LastSleeper=which;
+        if(++SleepersWoken==NumSleepers)
+                printf("All %d sleepers woke in order\n",NumSleepers);
+}
+void ThreadTest9(){
+        DEBUG('t', "Entering ThreadTest9\n");
+        LastWakeup=-1;
+        LastSleeper=-1;
+        SleepersWoken=0;
+        for(int i=0;i<NumSleepers;i++){
+                Thread* t=new Thread("sleeper");
+                t->Fork(Sleeper,(void*)i);
+        }
+}
+//----------------------------------------------------------------------
+// ThreadTest10
+//      Readers and writers sharing an RWLock.  Readers keep the lock
+//      busy, overlapping one another; each writer must still get in,
+//      and never while anyone else holds the lock.
+//----------------------------------------------------------------------
+#define RWReaders       6
+#define RWWriters       2
+#define RWRounds        10
+
+HostThreadLocal RWLock* RWTestLock;
+HostThreadLocal int RWActiveReaders=0;
+HostThreadLocal int RWActiveWriters=0;
+HostThreadLocal int RWWrites=0;
+
+void RWReader(int a){
+        for(int i=0;i<RWRounds;i++){
+                RWTestLock->ReadAcquire();
+                RWActiveReaders++;
+                ASSERT(RWActiveWriters==0);
+                currentThread->Yield();         // let others overlap us
+                ASSERT(RWActiveWriters==0);
+                RWActiveReaders--;
+                RWTestLock->ReadRelease();
+                currentThread->Yield();
+        }
+}
+void RWWriter(int a){
+        for(int i=0;i<RWRounds;i++){
+                RWTestLock->WriteAcquire();
+                RWActiveWriters++;
+                ASSERT(RWActiveWriters==1&&RWActiveReaders==0);
+                currentThread->Yield();
+                ASSERT(RWActiveWriters==1&&RWActiveReaders==0);
+                RWActiveWriters--;
+                RWWrites++;
+                printf("%s wrote, %d writes so far\n",
+                                currentThread->getName(),RWWrites);
+                RWTestLock->WriteRelease();
+                currentThread->Yield();
+        }
+}
+void ThreadTest10(){
+        DEBUG('t', "Entering ThreadTest10\n");
+        RWTestLock=new RWLock("Lock for reader-writer lock test");
+        for(int i=0;i<RWReaders;i++){
+                Thread* t=new Thread("reader");
+                t->Fork(RWReader,(void*)i);
+        }
+        for(int i=0;i<RWWriters;i++){
+                Thread* t=new Thread("writer");
+                t->Fork(RWWriter,(void*)i);
+        }
+}
+//----------------------------------------------------------------------
+// ThreadTest11
+//      Producers and consumers sharing a small SynchChannel.  First, a
+//      producer fills the channel and must then block in Send, until a
+//      consumer takes a batch out; the items must arrive in the order
+//      they were sent.  Then two producers and two consumers run at
+//      once, one of each moving items one at a time, the other in
+//      batches: every item must arrive exactly once, and each consumer
+//      must see each producer's items in order.
+//----------------------------------------------------------------------
+#define ChanCapacity    4
+#define ChanItems       40              // sent by each producer
+#define ChanBatch       6
+#define ChanTries       10              // yields to wait for a thread
+
+HostThreadLocal SynchChannel* TestChannel;
+HostThreadLocal bool ChanSending;       // producer is inside Send
+HostThreadLocal int ChanSum=0;
+HostThreadLocal int ChanReceived=0;
+
+void FullProducer(int a){
+        for(int next=1;next<=ChanCapacity;next++)
+                TestChannel->Send((void*)next);
+        ASSERT(!TestChannel->TrySend((void*)(ChanCapacity+2)));
+        ChanSending=TRUE;
+        TestChannel->Send((void*)(ChanCapacity+1));     // must block
+        ChanSending=FALSE;
+}
+void ChanProducer(int a){
+        void* items[ChanBatch];
+        int next=1;
+        while(next<=ChanItems){         // item: sequence #, producer #
+                if(a==0){               // one at a time
+                        TestChannel->Send((void*)(next++*2+a));
+                }else{                  // in batches
+                        int n=0;
+                        while(n<ChanBatch&&next<=ChanItems)
+                                items[n++]=(void*)(next++*2+a);
+                        TestChannel->SendBatch(items,n);
+                }
+                currentThread->Yield();
+        }
+}
+void ChanConsumer(int a){
+        void* items[ChanBatch];
+        int last[2]={0,0};              // last item seen from each producer
+        int left=ChanItems;             // each consumer takes its share
+        while(left>0){
+                int n;
+                if(a==0){
+                        if((items[0]=TestChannel->TryRecv())==NULL)
+                                items[0]=TestChannel->Recv();
+                        n=1;
+                }else{
+                        n=TestChannel->RecvBatch(items,min(left,ChanBatch));
+                }
+                for(int i=0;i<n;i++){
+                        int item=(int)items[i];
+                        ASSERT(item/2>last[item%2]);
+                        last[item%2]=item/2;
+                        ChanSum+=item/2;
+                }
+                ChanReceived+=n;
+                left-=n;
+                currentThread->Yield();
+        }
+        printf("%s done, %d items received, sum %d\n",
+                        currentThread->getName(),ChanReceived,ChanSum);
+        if(ChanReceived==2*ChanItems)
+                ASSERT(ChanSum==ChanItems*(ChanItems+1));
+}
+void FullConsumer(int a){
+        void* items[ChanBatch];
+        int tries;
+
+        for(tries=0;tries<ChanTries&&!ChanSending;tries++)
+                currentThread->Yield();
+        for(int i=0;i<ChanTries;i++)    // give it every chance to run
+                currentThread->Yield();
+        ASSERT(ChanSending&&TestChannel->NumItems()==ChanCapacity);
+        ASSERT(TestChannel->RecvBatch(items,ChanBatch)==ChanCapacity);
+        for(int i=0;i<ChanCapacity;i++)
+                ASSERT((int)items[i]==i+1);
+        for(tries=0;tries<ChanTries&&ChanSending;tries++)
+                currentThread->Yield();
+        ASSERT(!ChanSending&&TestChannel->NumItems()==1);
+        ASSERT((int)TestChannel->Recv()==ChanCapacity+1);
+        printf("%s: producer blocked while full, resumed after a batch\n",
+                        currentThread->getName());
+
+        for(int i=0;i<2;i++){
+                Thread* t=new Thread("producer");
+                t->Fork(ChanProducer,(void*)i);
+                t=new Thread("consumer");
+                t->Fork(ChanConsumer,(void*)i);
+        }
+}
+void ThreadTest11(){
+        DEBUG('t', "Entering ThreadTest11\n");
+        TestChannel=new SynchChannel("test channel",ChanCapacity);
+        ChanSending=FALSE;
+        Thread* t=new Thread("full producer");
+        t->Fork(FullProducer,(void*)0);
+        t=new Thread("full consumer");
+        t->Fork(FullConsumer,(void*)0);
+}
 //----------------------------------------------------------------------
 // ThreadTest
 // 	Invoke a test routine.
@@ -307,6 +640,18 @@ ThreadTest()
         case 7:
                 ThreadTest7();
                 break;
+        case 8:
+                ThreadTest8();          //priority inheritance latency
+                break;
+        case 9:
+                ThreadTest9();          //alarm clock
+                break;
+        case 10:
+                ThreadTest10();         //reader-writer lock
+                break;
+        case 11:
+                ThreadTest11();         //bounded channel
+                break;
         default:
                 printf("No test specified.\n");
                 break;
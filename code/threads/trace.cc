@@ -0,0 +1,259 @@
+// trace.cc 
+//	Routines for recording a timeline of the simulation, and writing
+//	it out in Chrome's trace-event JSON format.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "system.h"
+#include <stdarg.h>
+
+// The "process" each kind of track belongs to, in the trace viewer
+#define ThreadsPid	0		// one track per thread
+#define DevicesPid	1		// interrupts and the disk
+#define WaitsPid	2		// one track per thread
+
+//----------------------------------------------------------------------
+// Tracer::Tracer
+// 	Create the trace file, and start its list of events.
+//
+//	"fileName" is the UNIX file to write the trace to.
+//----------------------------------------------------------------------
+
+Tracer::Tracer(char *fileName)
+{
+    if ((file = fopen(fileName, "w")) == NULL) {
+	printf("Unable to open trace file %s\n", fileName);
+	ASSERT(FALSE);
+    }
+    buffer = new TraceEvent[TraceBufferSize];
+    head = count = numEvents = 0;
+    first = TRUE;
+    fprintf(file, "{\"traceEvents\":[\n");
+    Emit("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+	 "\"args\":{\"name\":\"threads\"}}", ThreadsPid);
+    Emit("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+	 "\"args\":{\"name\":\"devices\"}}", DevicesPid);
+    Emit("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+	 "\"args\":{\"name\":\"waits\"}}", WaitsPid);
+}
+
+//----------------------------------------------------------------------
+// Tracer::~Tracer
+// 	Write out whatever is still buffered, finish the list of events,
+//	and close the file.
+//----------------------------------------------------------------------
+
+Tracer::~Tracer()
+{
+    Flush();
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+    printf("Trace: %d events\n", numEvents);
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Record
+// 	Claim the next slot in the buffer -- writing the buffer out first,
+//	if it is full -- and stamp it with the time and the current thread.
+//----------------------------------------------------------------------
+
+TraceEvent *
+Tracer::Record(TraceKind kind)
+{
+    TraceEvent *event;
+
+    if (count == TraceBufferSize)
+	Flush();
+    event = &buffer[(head + count) % TraceBufferSize];
+    count++;
+    numEvents++;
+    event->kind = kind;
+    event->ticks = stats->totalTicks;
+    event->tid = (currentThread != NULL) ? currentThread->getTid() : 0;
+    event->name = NULL;
+    return event;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Switch
+// 	Record a context switch: oldThread's slice on the CPU ends, and
+//	nextThread's begins.
+//----------------------------------------------------------------------
+
+void
+Tracer::Switch(Thread *oldThread, Thread *nextThread)
+{
+    TraceEvent *event = Record(TraceSwitch);
+
+    event->tid = nextThread->getTid();
+    event->arg[0] = oldThread->getTid();
+    strncpy(event->thread, nextThread->getName(), TraceNameLen - 1);
+    event->thread[TraceNameLen - 1] = '\0';
+}
+
+//----------------------------------------------------------------------
+// Tracer::InterruptHandler
+// 	Record that an interrupt handler is being called.
+//
+//	"typeName" is the kind of device interrupting, as a static string.
+//----------------------------------------------------------------------
+
+void
+Tracer::InterruptHandler(char *typeName)
+{
+    Record(TraceInterrupt)->name = typeName;
+}
+
+//----------------------------------------------------------------------
+// Tracer::DiskRequest
+// 	Record a disk request, as a span covering its whole latency.
+//
+//	"sector" is the sector being read or written.
+//	"seek", "rotation" and "transfer" are the parts of the latency.
+//----------------------------------------------------------------------
+
+void
+Tracer::DiskRequest(int sector, bool writing, int seek, int rotation,
+		    int transfer)
+{
+    TraceEvent *event = Record(TraceDisk);
+
+    event->name = writing ? (char *) "disk write" : (char *) "disk read";
+    event->arg[0] = seek;
+    event->arg[1] = rotation;
+    event->arg[2] = transfer;
+    event->arg[3] = sector;
+}
+
+//----------------------------------------------------------------------
+// Tracer::PageFault, Tracer::TLBMiss, Tracer::Syscall
+// 	Record a page fault, a TLB miss or a system call, by the current
+//	thread.
+//----------------------------------------------------------------------
+
+void
+Tracer::PageFault(int vpn)
+{
+    Record(TracePageFault)->arg[0] = vpn;
+}
+
+void
+Tracer::TLBMiss(int virtAddr)
+{
+    Record(TraceTLBMiss)->arg[0] = virtAddr;
+}
+
+void
+Tracer::Syscall(int type)
+{
+    Record(TraceSyscall)->arg[0] = type;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Wait
+// 	Record a wait on a synchronization primitive, as a span from when
+//	the thread began waiting until now.
+//
+//	"what" is the kind of primitive, as a static string.
+//----------------------------------------------------------------------
+
+void
+Tracer::Wait(char *what, Thread *thread, int since)
+{
+    TraceEvent *event = Record(TraceWait);
+
+    event->name = what;
+    event->tid = thread->getTid();
+    event->arg[0] = since;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Flush
+// 	Write out the buffered events, oldest first, and empty the buffer.
+//----------------------------------------------------------------------
+
+void
+Tracer::Flush()
+{
+    for (; count > 0; count--) {
+	Write(&buffer[head]);
+	head = (head + 1) % TraceBufferSize;
+    }
+    fflush(file);
+}
+
+//----------------------------------------------------------------------
+// Tracer::Emit
+// 	Write one JSON object to the file, separated from the one before.
+//----------------------------------------------------------------------
+
+void
+Tracer::Emit(char *format, ...)
+{
+    va_list ap;
+
+    if (!first)
+	fprintf(file, ",\n");
+    first = FALSE;
+    va_start(ap, format);
+    vfprintf(file, format, ap);
+    va_end(ap);
+}
+
+//----------------------------------------------------------------------
+// Tracer::Write
+// 	Write one event as trace-event JSON.  A switch becomes the end of
+//	one thread's slice and the start of the other's; a disk request 
+//	becomes a complete event, as long as its latency, and so does a
+//	wait, on its own track; everything else is an instant.
+//----------------------------------------------------------------------
+
+void
+Tracer::Write(TraceEvent *e)
+{
+    switch (e->kind) {
+      case TraceSwitch:
+	Emit("{\"ph\":\"E\",\"ts\":%d,\"pid\":%d,\"tid\":%d}", 
+	     e->ticks, ThreadsPid, e->arg[0]);
+	Emit("{\"name\":\"%s\",\"cat\":\"sched\",\"ph\":\"B\",\"ts\":%d,"
+	     "\"pid\":%d,\"tid\":%d}", e->thread, e->ticks, ThreadsPid, 
+	     e->tid);
+	break;
+      case TraceInterrupt:
+	Emit("{\"name\":\"%s\",\"cat\":\"interrupt\",\"ph\":\"i\",\"s\":\"t\","
+	     "\"ts\":%d,\"pid\":%d,\"tid\":0}", e->name, e->ticks, DevicesPid);
+	break;
+      case TraceDisk:
+	Emit("{\"name\":\"%s\",\"cat\":\"disk\",\"ph\":\"X\",\"ts\":%d,"
+	     "\"dur\":%d,\"pid\":%d,\"tid\":1,\"args\":{\"sector\":%d,"
+	     "\"seek\":%d,\"rotation\":%d,\"transfer\":%d}}", e->name, 
+	     e->ticks, e->arg[0] + e->arg[1] + e->arg[2], DevicesPid, 
+	     e->arg[3], e->arg[0], e->arg[1], e->arg[2]);
+	break;
+      case TracePageFault:
+	Emit("{\"name\":\"page fault\",\"cat\":\"vm\",\"ph\":\"i\",\"s\":\"t\","
+	     "\"ts\":%d,\"pid\":%d,\"tid\":%d,\"args\":{\"vpn\":%d}}", 
+	     e->ticks, ThreadsPid, e->tid, e->arg[0]);
+	break;
+      case TraceTLBMiss:
+	Emit("{\"name\":\"tlb miss\",\"cat\":\"vm\",\"ph\":\"i\",\"s\":\"t\","
+	     "\"ts\":%d,\"pid\":%d,\"tid\":%d,\"args\":{\"vaddr\":%d}}", 
+	     e->ticks, ThreadsPid, e->tid, e->arg[0]);
+	break;
+      case TraceSyscall:
+	Emit("{\"name\":\"syscall %d\",\"cat\":\"syscall\",\"ph\":\"i\","
+	     "\"s\":\"t\",\"ts\":%d,\"pid\":%d,\"tid\":%d}", 
+	     e->arg[0], e->ticks, ThreadsPid, e->tid);
+	break;
+      case TraceWait:
+	Emit("{\"name\":\"%s wait\",\"cat\":\"sync\",\"ph\":\"X\","
+	     "\"ts\":%d,\"dur\":%d,\"pid\":%d,\"tid\":%d}", e->name, e->arg[0], 
+	     e->ticks - e->arg[0], WaitsPid, e->tid);
+	break;
+    }
+}
@@ -0,0 +1,91 @@
+// trace.h 
+//	Data structures for recording a timeline of the simulation, as a
+//	Chrome trace-event file that chrome://tracing or Perfetto can
+//	display.
+//
+//	Tracing is turned on with "-tr <file>"; the global "tracer" is 
+//	NULL otherwise, and each hook costs only a test of that pointer.
+//	Events are stamped with stats->totalTicks (shown as microseconds)
+//	and kept in a fixed ring buffer, which is written out to the file
+//	whenever it fills up, and once more when the machine halts.
+//
+//	The events recorded are:
+//		thread switches, one track per thread id
+//		interrupts, by type
+//		disk requests, with their seek, rotation and transfer time
+//		page faults and TLB misses
+//		system calls
+//		waits on semaphores, locks and condition variables, one 
+//		    track per thread id (only with "-lt", which times them)
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include <stdio.h>
+
+class Thread;
+
+#define TraceBufferSize	4096		// events buffered between writes
+#define TraceNameLen	16		// room for a thread's name
+
+// The kinds of events in the trace
+enum TraceKind { TraceSwitch, TraceInterrupt, TraceDisk, TracePageFault,
+		 TraceTLBMiss, TraceSyscall, TraceWait };
+
+// The following class defines one event, as buffered.  What the 
+// arguments mean depends on the kind of event.
+
+class TraceEvent {
+  public:
+    TraceKind kind;
+    int ticks;				// when it happened
+    int tid;				// thread it happened to
+    int arg[4];
+    char *name;				// static string, or NULL
+    char thread[TraceNameLen];		// thread name, for switches
+};
+
+// The following class defines the tracer for one simulated machine.
+
+class Tracer {
+  public:
+    Tracer(char *fileName);		// start a trace file
+    ~Tracer();				// write out the rest, and close it
+
+    void Switch(Thread *oldThread, Thread *nextThread);
+					// nextThread replaces oldThread 
+					// on the CPU
+    void InterruptHandler(char *typeName);
+					// an interrupt handler is called
+    void DiskRequest(int sector, bool writing, int seek, int rotation,
+		     int transfer);	// a disk request is started
+    void PageFault(int vpn);		// a page is brought into memory
+    void TLBMiss(int virtAddr);		// a TLB entry is refilled
+    void Syscall(int type);		// a system call is made
+    void Wait(char *what, Thread *thread, int since);
+					// thread has stopped waiting on
+					// a "what", which it began at
+					// "since"
+
+    void Flush();			// write out the buffered events
+
+  private:
+    FILE *file;				// where the trace goes
+    bool first;				// nothing written yet?
+    TraceEvent *buffer;			// circular buffer of events
+    int head;				// index of the oldest event
+    int count;				// # of events in the buffer
+    int numEvents;			// # of events recorded in all
+
+    TraceEvent *Record(TraceKind kind);	// claim the next event
+    void Write(TraceEvent *event);	// write one event to the file
+    void Emit(char *format, ...);	// write one JSON object
+};
+
+#endif // TRACE_H
@@ -21,14 +21,18 @@
 #endif
 #endif
 
-static char *enableFlags = NULL; // controls which DEBUG messages are printed 
+HostThreadLocal DebugMask debugFlags = 0;
+				// controls which DEBUG messages are printed;
+				// one set per simulation
 
 //----------------------------------------------------------------------
 // DebugInit
 //      Initialize so that only DEBUG messages with a flag in flagList 
 //	will be printed.
 //
-//	If the flag is "+", we enable all DEBUG messages.
+//	If the flag is "+", we enable all DEBUG messages.  Flags that were
+//	compiled out of this build (see DEBUG_MASK) are reported, since 
+//	asking for them does nothing.
 //
 // 	"flagList" is a string of characters for whose DEBUG messages are 
 //		to be enabled.
@@ -37,39 +41,31 @@ static char *enableFlags = NULL; // controls which DEBUG messages are printed
 void
 DebugInit(char *flagList)
 {
-    enableFlags = flagList;
-}
-
-//----------------------------------------------------------------------
-// DebugIsEnabled
-//      Return TRUE if DEBUG messages with "flag" are to be printed.
-//----------------------------------------------------------------------
-
-bool
-DebugIsEnabled(char flag)
-{
-    if (enableFlags != NULL)
-       return (strchr(enableFlags, flag) != 0) 
-		|| (strchr(enableFlags, '+') != 0);
-    else
-      return FALSE;
+    debugFlags = 0;
+    for (char *flag = flagList; *flag != '\0'; flag++) {
+	if (*flag == '+') {
+	    debugFlags = ~(DebugMask) 0;
+	    continue;
+	}
+	debugFlags |= DebugBit(*flag);
+	if ((DEBUG_MASK & DebugBit(*flag)) == 0)
+	    printf("Debug flag '%c' is compiled out of this build\n", *flag);
+    }
 }
 
 //----------------------------------------------------------------------
-// DEBUG
-//      Print a debug message, if flag is enabled.  Like printf,
-//	only with an extra argument on the front.
+// DebugPrint
+//      Print a debug message.  Like printf; the DEBUG macro has already
+//	checked that its flag is enabled.
 //----------------------------------------------------------------------
 
 void 
-DEBUG(char flag, char *format, ...)
+DebugPrint(char *format, ...)
 {
-    if (DebugIsEnabled(flag)) {
-	va_list ap;
-	// You will get an unused variable message here -- ignore it.
-	va_start(ap, format);
-	vfprintf(stdout, format, ap);
-	va_end(ap);
-	fflush(stdout);
-    }
+    va_list ap;
+
+    va_start(ap, format);
+    vfprintf(stdout, format, ap);
+    va_end(ap);
+    fflush(stdout);
 }
@@ -15,6 +15,17 @@
 //   	'f' -- file system (FILESYS)
 //   	'a' -- address spaces (USER_PROGRAM)
 //   	'n' -- network emulation (NETWORK)
+//   	'h' -- slab caches of kernel objects
+//
+//	Each flag is a bit in a mask.  DEBUG and DebugIsEnabled are macros
+//	that test the bit -- first against DEBUG_MASK, the flags compiled
+//	into this build, and then against the flags turned on with -d -- 
+//	before evaluating any of their arguments.  For a flag that is not
+//	in DEBUG_MASK, the test is constant, and the compiler throws the 
+//	whole statement away; for the others, it is a single branch.  
+//	DEBUG_MASK is every flag, unless the build sets it (see DEBUGMASK 
+//	in Makefile.common), e.g. to 0 for a build with no DEBUG at all, 
+//	or to (DebugBit('f') | DebugBit('d')) for just the file system.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -58,12 +69,36 @@ typedef void (*VoidNoArgFunctionPtr)();
 
 // Interface to debugging routines.
 
+typedef unsigned long long DebugMask;	// one bit per debug flag
+
+// The bit for a flag: 'a'-'z' and 'A'-'Z' each have their own; any 
+// other character shares the top one.
+#define DebugBit(flag)							      \
+    ((DebugMask) 1 << (((flag) >= 'a' && (flag) <= 'z') ? (flag) - 'a' :     \
+		       ((flag) >= 'A' && (flag) <= 'Z') ? (flag) - 'A' + 26 : \
+		       63))
+
+#ifndef DEBUG_MASK
+#define DEBUG_MASK	(~(DebugMask) 0)	// every flag compiled in
+#endif
+
 extern void DebugInit(char* flags);	// enable printing debug messages
 
-extern bool DebugIsEnabled(char flag); 	// Is this debug flag enabled?
+extern HostThreadLocal DebugMask debugFlags;	// flags enabled with -d
+
+// Is this debug flag enabled?
+#define DebugIsEnabled(flag)						      \
+    ((DEBUG_MASK & DebugBit(flag)) != 0 && (debugFlags & DebugBit(flag)) != 0)
+
+// Print debug message if flag is enabled
+#define DEBUG(flag, ...)						      \
+    do {								      \
+	if (DebugIsEnabled(flag))					      \
+	    DebugPrint(__VA_ARGS__);					      \
+    } while (0)
 
-extern void DEBUG (char flag, char* format, ...);  	// Print debug message 
-							// if flag is enabled
+extern void DebugPrint(char* format, ...);	// print a debug message,
+						// unconditionally
 
 //----------------------------------------------------------------------
 // ASSERT
@@ -104,6 +104,7 @@ AddrSpace::AddrSpace(OpenFile *executable)
 						// to leave room for the stack
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
+    numThreads = 1;
 
 	// all the pageTableEntry are invalid 
 	// when accessing the memory 
@@ -157,6 +158,68 @@ AddrSpace::AddrSpace(OpenFile *executable)
 #endif
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::AddStack
+// 	Grow the address space by a stack for another thread, forked to
+//	run in it (see SC_Fork), and return the thread's initial stack
+//	pointer.  Like the rest of the space, the new pages are brought
+//	into memory on the first fault.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AddStack()
+{
+    unsigned int i, oldPages = numPages;
+    TranslationEntry *oldTable = pageTable;
+    bool current = (machine->pageTable == pageTable);
+
+    if (current)
+	SaveState();			// the TLB has our latest entries
+    numPages += divRoundUp(UserStackSize, PageSize);
+    pageTable = new TranslationEntry[numPages];
+    for (i = 0; i < numPages; i++) {
+	if (i < oldPages)
+	    pageTable[i] = oldTable[i];
+	else {
+	    pageTable[i].valid = false;
+	    pageTable[i].dirty = false;
+	}
+    }
+    delete [] oldTable;
+#ifdef DiskImage
+	// the image file has a fixed size, so copy it into a new, larger
+	// one, named for the thread and the new size -- pages still in
+	// memory are written back to the new file when they are evicted
+    char imageName[32];
+    char *image = new char[numPages * PageSize];
+    OpenFile *newSpace;
+
+    sprintf(imageName, "%d.%d.das", currentThread->getTid(), numPages);
+    if (!fileSystem->Create(imageName, numPages * PageSize)) {
+	printf("failed to grow the disk address space to %s\n", imageName);
+	ASSERT(FALSE);
+    }
+    newSpace = fileSystem->Open(imageName);
+    memset(image, 0, numPages * PageSize);
+    DiskAddrSpace->ReadAt(image, oldPages * PageSize, 0);
+    newSpace->WriteAt(image, numPages * PageSize, 0);
+    delete [] image;
+    delete DiskAddrSpace;
+    DiskAddrSpace = newSpace;
+#else
+    char *oldSpace = vSpace;
+    vSpace = new char[numPages * PageSize];
+    memcpy(vSpace, oldSpace, oldPages * PageSize);
+    memset(vSpace + oldPages * PageSize, 0, (numPages - oldPages) * PageSize);
+    delete [] oldSpace;
+#endif
+    if (current)
+	RestoreState();
+    numThreads++;
+    DEBUG('a', "Added a stack, %d threads, %d pages\n", numThreads, numPages);
+    return numPages * PageSize - 16;
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
 // 	Dealloate an address space.  Nothing for now!
@@ -24,7 +24,7 @@ class AddrSpace {
 					// initializing it with the program
 					// stored in the file "executable"
     ~AddrSpace();			// De-allocate an address space
-    AddrSpace(){}
+    AddrSpace() { numThreads = 1; }
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
@@ -38,11 +38,15 @@ class AddrSpace {
 	char * vSpace;
 	#endif
 	void CopyFrom(AddrSpace * from);
+	int AddStack();			// Make room for another thread's
+					// stack; return its stack pointer
 
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    int numThreads;			// Number of threads running in
+					// the address space
 };
 
 #endif // ADDRSPACE_H
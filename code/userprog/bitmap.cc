@@ -9,6 +9,8 @@
 #include "copyright.h"
 #include "bitmap.h"
 
+SLAB_ALLOCATED(BitMap)		// see slab.h
+
 //----------------------------------------------------------------------
 // BitMap::BitMap
 // 	Initialize a bitmap with "nitems" bits, so that every bit is clear.
@@ -164,6 +166,27 @@ BitMap::WriteBack(OpenFile *file)
    file->WriteAt((char *)map, numWords * sizeof(unsigned), 0);
 }
 
+//----------------------------------------------------------------------
+// BitMap::CopyFrom, BitMap::CopyTo
+// 	Copy the contents of a bitmap from or to memory, laid out as in 
+//	FetchFrom and WriteBack -- for a bitmap the caller keeps on disk
+//	some other way.
+//
+//	"bits" is the place to copy the bitmap from, or to
+//----------------------------------------------------------------------
+
+void
+BitMap::CopyFrom(char *bits)
+{
+    bcopy(bits, (char *)map, numWords * sizeof(unsigned));
+}
+
+void
+BitMap::CopyTo(char *bits)
+{
+    bcopy((char *)map, bits, numWords * sizeof(unsigned));
+}
+
 int BitMap::FindN(int cnt){
 	for (int i = 0; i < numBits; i++){
 		int flag = 1;
@@ -16,6 +16,7 @@
 #define BITMAP_H
 
 #include "copyright.h"
+#include "slab.h"
 #include "utility.h"
 #include "openfile.h"
 
@@ -33,6 +34,9 @@
 
 class BitMap {
   public:
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *object);	// see slab.h
+
     BitMap(int nitems);		// Initialize a bitmap, with "nitems" bits
 				// initially, all bits are cleared.
     ~BitMap();			// De-allocate bitmap
@@ -51,6 +55,9 @@ class BitMap {
     // write the bitmap to a file
     void FetchFrom(OpenFile *file); 	// fetch contents from disk 
     void WriteBack(OpenFile *file); 	// write contents to disk
+    void CopyFrom(char *bits);		// copy contents from memory, 
+    void CopyTo(char *bits);		// or to it, in the same layout as 
+					// on disk
     int FindN(int cnt);
 
   private:
@@ -56,18 +56,44 @@
 struct ForkInfo{
 	AddrSpace* caller;
 	int pc;	
+	int sp;				// Fork: the new thread's stack
 };
+// A thread forked by a user program runs in the *same* address space
+// as its parent, on a stack of its own (see syscall.h)
 void ForkWrapper(int x){;
 	ForkInfo* info=(ForkInfo*)x;
-	AddrSpace* addrspace=new AddrSpace();
-	addrspace->CopyFrom(info->caller);
-	currentThread->space=addrspace;
-	addrspace->RestoreState();
+	currentThread->space=info->caller;
+	info->caller->RestoreState();
 	machine->WriteRegister(PCReg,info->pc);
 	machine->WriteRegister(NextPCReg,(info->pc)+4);
+	machine->WriteRegister(StackReg,info->sp);
+	delete info;
 	currentThread->SaveUserState();
 	machine->Run();
 }
+// A thread that exits while others still run in its address space gives
+// up the physical pages it brought in: they are written back to the
+// space, for the others to fault in again, so that no physical page is
+// left owned by a dead thread
+static void ReleaseThreadPages(){
+	AddrSpace* space=currentThread->space;
+	space->SaveState();		// the TLB has the latest entries
+	for(int ppn=0;ppn<NumPhysPages;ppn++){
+		PhysicalPageEntry* page=&PhysicalPageTable[ppn];
+		if(!page->valid||page->OwnerThread!=currentThread)
+			continue;
+		#ifdef DiskImage
+		space->DiskAddrSpace->WriteAt(&(machine->mainMemory[ppn*PageSize]),
+			PageSize,page->VirtualPageNumber*PageSize);
+		#else
+		memcpy(&(space->vSpace[page->VirtualPageNumber*PageSize]),
+			&(machine->mainMemory[ppn*PageSize]),PageSize);
+		#endif
+		space->pageTable[page->VirtualPageNumber].valid=false;
+		page->valid=false;
+		page->dirty=false;
+	}
+}
 void ExecWrapper(int x){
 	ForkInfo* info=(ForkInfo*)x;
 	currentThread->space=info->caller;
@@ -105,6 +131,8 @@ ExceptionHandler(ExceptionType which)
 {
 	int type = machine->ReadRegister(2);
 	if(which==SyscallException){
+		if(tracer!=NULL)
+			tracer->Syscall(type);
 		switch (type){
 		case SC_Halt:{
 			DEBUG('A',"Halt ,initiated by user program tid =%d,name %s.\n",currentThread->getTid(),currentThread->getName());
@@ -112,7 +140,14 @@ ExceptionHandler(ExceptionType which)
 			break;
 		}
 		case SC_Exit:{
-			if(1){
+			if(currentThread->space->numThreads>1){
+				currentThread->space->numThreads--;
+				ReleaseThreadPages();
+				DEBUG('A',"thread %d %s finished with code %d\n",currentThread->getTid(),currentThread->getName(),machine->ReadRegister(4));
+				machine->IncrementPC();
+				currentThread->Finish();
+			}
+			else if(1){
 				for(int i=0;i<machine->pageTableSize;i++){
 					if(machine->pageTable[i].valid){
 						machine->pageTable[i].valid=false;
@@ -254,6 +289,7 @@ ExceptionHandler(ExceptionType which)
 			ForkInfo *info=new ForkInfo;
 			info->caller=currentThread->space;
 			info->pc=funcPc;
+			info->sp=currentThread->space->AddStack();
 			Thread * t1=new Thread("Forked by system call");
 			t1->Fork(ForkWrapper,info);
 			machine->WriteRegister(2,t1->getTid());
@@ -266,11 +302,95 @@ ExceptionHandler(ExceptionType which)
 			currentThread->Yield();
 			break;
 		}
+		case SC_Sleep:{
+			int ticks=machine->ReadRegister(4);
+			DEBUG('A',"Sleep for %d ticks ,initiated by user program.\n",ticks);
+			machine->IncrementPC();
+			alarmClock->Pause(ticks);
+			break;
+		}
+		case SC_FutexWait:{
+			int addr=machine->ReadRegister(4);
+			int expected=machine->ReadRegister(5);
+			DEBUG('A',"FutexWait on 0x%x ,initiated by user program.\n",addr);
+			machine->IncrementPC();
+			machine->WriteRegister(2,futexTable->Wait(currentThread->space,addr,expected));
+			break;
+		}
+		case SC_FutexWake:{
+			int addr=machine->ReadRegister(4);
+			int count=machine->ReadRegister(5);
+			DEBUG('A',"FutexWake on 0x%x ,initiated by user program.\n",addr);
+			machine->IncrementPC();
+			machine->WriteRegister(2,futexTable->Wake(currentThread->space,addr,count));
+			break;
+		}
+		case SC_Sync:{
+			DEBUG('A',"Sync ,initiated by user program.\n");
+			machine->IncrementPC();
+		#ifdef FILESYS
+			synchDisk->Sync();
+		#endif
+			break;
+		}
+		case SC_Fsync:{
+			OpenFile *openfile=(OpenFile *)machine->ReadRegister(4);
+			DEBUG('A',"Fsync ,initiated by user program.\n");
+			machine->IncrementPC();
+			if((int)openfile!=ConsoleInput && (int)openfile!=ConsoleOutput)
+				openfile->Sync();
+			break;
+		}
+		case SC_AioRead:
+		case SC_AioWrite:{
+			int addr=machine->ReadRegister(4);
+			int size=machine->ReadRegister(5);
+			int position=machine->ReadRegister(6);
+			OpenFile *openfile=(OpenFile *)machine->ReadRegister(7);
+			AioRequest *request=NULL;
+			DEBUG('A',"%s ,initiated by user program.\n",
+				type==SC_AioRead?"AioRead":"AioWrite");
+			machine->IncrementPC();
+			if((int)openfile!=ConsoleInput && (int)openfile!=ConsoleOutput
+			   && size>0){
+				char *data=new char[size];
+				int tmp=0;
+				if(type==SC_AioWrite){
+					for(int i=0;i<size;i++){
+						machine->ReadMem(addr+i,1,&tmp);
+						data[i]=(char)tmp;
+					}
+					request=openfile->WriteAtAsync(data,size,position);
+				}else{
+					request=openfile->ReadAtAsync(data,size,position);
+					request->userAddr=addr;
+				}
+			}
+			machine->WriteRegister(2,(int)request);
+			break;
+		}
+		case SC_AioWait:{
+			AioRequest *request=(AioRequest *)machine->ReadRegister(4);
+			int res=-1;
+			DEBUG('A',"AioWait ,initiated by user program.\n");
+			machine->IncrementPC();
+			if(request!=NULL){
+				res=request->Wait();
+				if(request->userAddr!=-1)
+					for(int i=0;i<res;i++)
+						machine->WriteMem(request->userAddr+i,1,
+							int(request->Buffer()[i]));
+				delete [] request->Buffer();
+				delete request;
+			}
+			machine->WriteRegister(2,res);
+			break;
+		}
 		case SC_Join:{
 			DEBUG('A',"Join ,initiated by user program.\n");
 			int tid=machine->ReadRegister(4);
 			DEBUG('A',"Join ,caller id = %d ,waiting id =%d",currentThread->getTid(),tid);
-			while (TidMap[tid]&&tid!=currentThread->getTid()){
+			while (threadTable->Lookup(tid)!=NULL&&tid!=currentThread->getTid()){
 				DEBUG('A',"Yield caused by join\n");
 				currentThread->Yield();
 			}
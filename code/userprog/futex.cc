@@ -0,0 +1,150 @@
+// futex.cc 
+//	Routines to put user threads to sleep on a word of their memory,
+//	and wake them up again.  See futex.h.
+//
+//	Checking the word and going to sleep must be atomic with respect
+//	to other user threads, or a FutexWake could slip in between and
+//	be lost.  User threads only run while the kernel lets them, so 
+//	disabling interrupts is enough.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "futex.h"
+#include "system.h"
+
+// A queue is made and destroyed every time a lock goes from uncontended
+// to contended and back.
+SLAB_ALLOCATED(FutexQueue)		// see slab.h
+
+//----------------------------------------------------------------------
+// FutexTable::FutexTable
+// 	Initialize an empty table of wait queues.
+//----------------------------------------------------------------------
+
+FutexTable::FutexTable()
+{
+    for (int i = 0; i < FutexBuckets; i++)
+	buckets[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::~FutexTable
+// 	De-allocate the table, and any queues still in it (the threads on
+//	them will never be woken up anyway).
+//----------------------------------------------------------------------
+
+FutexTable::~FutexTable()
+{
+    for (int i = 0; i < FutexBuckets; i++)
+	while (buckets[i] != NULL) {
+	    FutexQueue *queue = buckets[i];
+
+	    buckets[i] = queue->next;
+	    while (queue->waiters.Remove() != NULL)
+		;
+	    delete queue;
+	}
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Find
+// 	Return the link that points to the queue for the word at "vaddr"
+//	in "space" -- either the head of a hash chain, or the "next" field
+//	of the queue before it.  If no one is waiting on the word, the 
+//	link points to NULL, and a new queue can be put there.
+//----------------------------------------------------------------------
+
+FutexQueue **
+FutexTable::Find(AddrSpace *space, int vaddr)
+{
+    unsigned int hash = ((unsigned int) vaddr >> 2) ^ (unsigned int) space;
+    FutexQueue **pp;
+
+    for (pp = &buckets[hash % FutexBuckets]; *pp != NULL; pp = &(*pp)->next)
+	if ((*pp)->space == space && (*pp)->vaddr == vaddr)
+	    break;
+    return pp;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wait
+// 	Put the current thread to sleep on the word at "vaddr" in "space",
+//	unless the word no longer holds "expected" -- that is, unless the 
+//	thread we would wait for has already changed it, and so may have
+//	already tried to wake us up.
+//
+//	The word is read with interrupts still enabled, since reading it
+//	may fault the page in; no simulated time passes between the read
+//	and going to sleep, so no other thread can change it meanwhile.
+//
+//	Returns 0 if we slept and were woken up, -1 if the word had 
+//	changed, or could not be read.  Either way, the caller should look
+//	at the word again.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wait(AddrSpace *space, int vaddr, int expected)
+{
+    IntStatus oldLevel;
+    FutexQueue **pp;
+    int value;
+
+    if ((vaddr & 0x3) != 0)
+	return -1;
+    if (!machine->ReadMem(vaddr, 4, &value)	// the first try may only
+	    && !machine->ReadMem(vaddr, 4, &value))	// fault the page in
+	return -1;
+    if (value != expected)
+	return -1;
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    pp = Find(space, vaddr);
+    if (*pp == NULL) {
+	*pp = new FutexQueue(space, vaddr);
+	(*pp)->next = NULL;
+    }
+    DEBUG('A', "Thread %d waits on futex 0x%x\n", currentThread->getTid(), 
+	vaddr);
+    (*pp)->waiters.SortedInsert(currentThread, currentThread->getPriority());
+    currentThread->Sleep();
+    (void) interrupt->SetLevel(oldLevel);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wake
+// 	Wake up to "count" threads sleeping on the word at "vaddr" in
+//	"space", highest priority first.  Returns how many were woken.
+//
+//	The threads are taken off the queue, and the queue deleted if
+//	that empties it, before any of them is made ready: making a 
+//	thread ready may switch to it, and it may change the table.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wake(AddrSpace *space, int vaddr, int count)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    FutexQueue **pp = Find(space, vaddr);
+    FutexQueue *queue = *pp;
+    IntrusiveList<Thread> woken;
+    int numWoken;
+
+    if (queue != NULL) {
+	while (woken.NumInList() < count && !queue->waiters.IsEmpty())
+	    woken.Append(queue->waiters.Remove());
+	if (queue->waiters.IsEmpty()) {	// no one left waiting on the word
+	    *pp = queue->next;
+	    delete queue;
+	}
+    }
+    numWoken = woken.NumInList();
+    DEBUG('A', "Waking %d threads on futex 0x%x\n", numWoken, vaddr);
+    while (!woken.IsEmpty())
+	scheduler->ReadyToRun(woken.Remove());
+    (void) interrupt->SetLevel(oldLevel);
+    return numWoken;
+}
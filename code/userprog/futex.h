@@ -0,0 +1,69 @@
+// futex.h 
+//	Data structures for "fast user-space mutexes": kernel wait queues
+//	that user programs can sleep on, named by the address of a word of
+//	their own memory.
+//
+//	A user-level lock or condition variable (see test/usync.c) keeps
+//	its state in an ordinary word, and changes it with atomic
+//	instructions, without entering the kernel; only when a thread has
+//	to wait does it call FutexWait, and only when a thread may have to
+//	be woken up does its partner call FutexWake.
+//
+//	Queues are created when the first thread waits on a word, and
+//	deleted when the last one is woken, so the table holds only the
+//	words someone is waiting on, hashed by address space and address.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "copyright.h"
+#include "ilist.h"
+#include "slab.h"
+
+class Thread;
+class AddrSpace;
+
+#define FutexBuckets	64		// hash chains in the futex table
+
+// The following class defines the queue of threads waiting on one word.
+
+class FutexQueue {
+  public:
+    void *operator new(size_t size);	// allocated from a slab cache,
+    void operator delete(void *object);	// see slab.h
+
+    FutexQueue(AddrSpace *s, int addr) { space = s; vaddr = addr; }
+
+    AddrSpace *space;			// the word is "vaddr" in "space"
+    int vaddr;
+    IntrusiveList<Thread> waiters;	// highest priority first
+    FutexQueue *next;			// next queue on the hash chain
+};
+
+// The following class defines the table of all futex wait queues.
+
+class FutexTable {
+  public:
+    FutexTable();			// initialize an empty table
+    ~FutexTable();			// de-allocate the table
+
+    int Wait(AddrSpace *space, int vaddr, int expected);
+					// sleep on the word at "vaddr", if 
+					// it still holds "expected"
+    int Wake(AddrSpace *space, int vaddr, int count);
+					// wake up to "count" threads
+					// sleeping on the word at "vaddr"
+
+  private:
+    FutexQueue *buckets[FutexBuckets];	// hash chains of queues
+
+    FutexQueue **Find(AddrSpace *space, int vaddr);
+					// the link to the queue for a word,
+					// or to the end of its chain
+};
+
+#endif // FUTEX_H
@@ -0,0 +1,487 @@
+// profile.cc 
+//	Routines for profiling user programs, and for writing out the
+//	results.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "system.h"
+
+#define MaxSymbolLen	64		// longest name we keep
+#define MaxStackLen	4096		// longest folded stack we write
+
+//----------------------------------------------------------------------
+// ProfileTable::ProfileTable, ProfileTable::~ProfileTable
+// 	Initialize an empty table of counts, or de-allocate one.
+//----------------------------------------------------------------------
+
+ProfileTable::ProfileTable()
+{
+    size = ProfileInitialSize;
+    numEntries = 0;
+    table = new ProfileCounts[size];
+    for (int i = 0; i < size; i++)
+	table[i].addr = -1;
+}
+
+ProfileTable::~ProfileTable()
+{
+    delete [] table;
+}
+
+//----------------------------------------------------------------------
+// ProfileTable::Find
+// 	Return the counts for an address, adding zeroed counts if it is
+//	not in the table yet.  Instructions are word-aligned, so the low
+//	two bits are dropped before hashing.
+//----------------------------------------------------------------------
+
+ProfileCounts *
+ProfileTable::Find(int addr)
+{
+    unsigned int i = ((unsigned) addr >> 2) & (size - 1);
+    ProfileCounts *entry;
+
+    while (table[i].addr != -1) {
+	if (table[i].addr == addr)
+	    return &table[i];
+	i = (i + 1) & (size - 1);
+    }
+    if (2 * (numEntries + 1) > size) {	// keep the table half empty
+	Grow();
+	return Find(addr);
+    }
+    numEntries++;
+    entry = &table[i];
+    entry->addr = addr;
+    entry->count = entry->instructions = 0;
+    entry->tlbMisses = entry->tlbTicks = 0;
+    entry->pageFaults = entry->faultTicks = 0;
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// ProfileTable::Grow
+// 	Double the size of the table, and re-hash its entries.  Pointers
+//	returned by Find before this are no longer valid.
+//----------------------------------------------------------------------
+
+void
+ProfileTable::Grow()
+{
+    ProfileCounts *old = table;
+    int oldSize = size;
+
+    size *= 2;
+    table = new ProfileCounts[size];
+    for (int i = 0; i < size; i++)
+	table[i].addr = -1;
+    for (int i = 0; i < oldSize; i++) {
+	unsigned int j;
+
+	if (old[i].addr == -1)
+	    continue;
+	j = ((unsigned) old[i].addr >> 2) & (size - 1);
+	while (table[j].addr != -1)
+	    j = (j + 1) & (size - 1);
+	table[j] = old[i];
+    }
+    delete [] old;
+}
+
+//----------------------------------------------------------------------
+// ProfileTable::Sorted
+// 	Return an array of pointers to every entry, sorted by address.
+//
+//	Shell sort, with gaps 1, 4, 13, 40, ...
+//
+//	"n" is set to the number of entries.
+//----------------------------------------------------------------------
+
+ProfileCounts **
+ProfileTable::Sorted(int *n)
+{
+    ProfileCounts **entries = new ProfileCounts *[numEntries + 1];
+    int gap;
+
+    *n = 0;
+    for (int i = 0; i < size; i++)
+	if (table[i].addr != -1)
+	    entries[(*n)++] = &table[i];
+    for (gap = 1; gap < *n / 3; gap = 3 * gap + 1)
+	;
+    for (; gap > 0; gap /= 3)
+	for (int i = gap; i < *n; i++) {
+	    ProfileCounts *entry = entries[i];
+	    int j;
+
+	    for (j = i; j >= gap && (unsigned) entries[j - gap]->addr 
+					> (unsigned) entry->addr; j -= gap)
+		entries[j] = entries[j - gap];
+	    entries[j] = entry;
+	}
+    return entries;
+}
+
+//----------------------------------------------------------------------
+// ProfileNode::ProfileNode, ProfileNode::~ProfileNode
+// 	Initialize a node of the call-stack tree, or de-allocate a 
+//	whole subtree.
+//----------------------------------------------------------------------
+
+ProfileNode::ProfileNode(int entryPC, ProfileNode *caller)
+{
+    entry = entryPC;
+    instructions = 0;
+    parent = caller;
+    children = sibling = NULL;
+}
+
+ProfileNode::~ProfileNode()
+{
+    ProfileNode *child, *next;
+
+    for (child = children; child != NULL; child = next) {
+	next = child->sibling;
+	delete child;
+    }
+}
+
+//----------------------------------------------------------------------
+// ProfileNode::Child
+// 	Return the node for a function called from this one, adding it
+//	if this is the first such call.
+//----------------------------------------------------------------------
+
+ProfileNode *
+ProfileNode::Child(int entryPC)
+{
+    ProfileNode *child;
+
+    for (child = children; child != NULL; child = child->sibling)
+	if (child->entry == entryPC)
+	    return child;
+    child = new ProfileNode(entryPC, this);
+    child->sibling = children;
+    children = child;
+    return child;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Profiler
+// 	Initialize empty counts, and read in the symbol table, if any.
+//
+//	"outFile" is the UNIX file to write the results to.
+//	"symbolFile" is the output of "nm -n" for the program, or NULL.
+//----------------------------------------------------------------------
+
+Profiler::Profiler(char *outFile, char *symbolFile)
+{
+    fileName = outFile;
+    for (int i = 0; i < ProfileOpcodes; i++)
+	opCounts[i] = 0;
+    root = new ProfileNode(0, NULL);
+    numInstructions = 0;
+    faulted = FALSE;
+    numSymbols = 0;
+    symbolAddrs = NULL;
+    symbolNames = NULL;
+    if (symbolFile != NULL)
+	ReadSymbols(symbolFile);
+}
+
+//----------------------------------------------------------------------
+// Profiler::~Profiler
+// 	De-allocate the profiler.
+//----------------------------------------------------------------------
+
+Profiler::~Profiler()
+{
+    delete root;
+    for (int i = 0; i < numSymbols; i++)
+	delete [] symbolNames[i];
+    delete [] symbolNames;
+    delete [] symbolAddrs;
+}
+
+//----------------------------------------------------------------------
+// Profiler::ReadSymbols
+// 	Read the text symbols from the output of "nm -n": lines of the
+//	form "<hex address> <type> <name>", in order of address.  Symbols
+//	of other types (data, undefined, ...) are skipped.
+//----------------------------------------------------------------------
+
+void
+Profiler::ReadSymbols(char *symbolFile)
+{
+    FILE *file;
+    char line[256], name[MaxSymbolLen];
+    unsigned int addr;
+    char type;
+    int room = 256;
+
+    if ((file = fopen(symbolFile, "r")) == NULL) {
+	printf("Unable to open symbol file %s\n", symbolFile);
+	return;
+    }
+    symbolAddrs = new int[room];
+    symbolNames = new char *[room];
+    while (fgets(line, sizeof(line), file) != NULL) {
+	if (sscanf(line, "%x %c %63s", &addr, &type, name) != 3 
+		|| (type != 'T' && type != 't'))
+	    continue;
+	if (numSymbols == room) {		// make more room
+	    int *addrs = new int[2 * room];
+	    char **names = new char *[2 * room];
+
+	    for (int i = 0; i < numSymbols; i++) {
+		addrs[i] = symbolAddrs[i];
+		names[i] = symbolNames[i];
+	    }
+	    delete [] symbolAddrs;
+	    delete [] symbolNames;
+	    symbolAddrs = addrs;
+	    symbolNames = names;
+	    room *= 2;
+	}
+	symbolAddrs[numSymbols] = addr;
+	symbolNames[numSymbols] = new char[strlen(name) + 1];
+	strcpy(symbolNames[numSymbols], name);
+	numSymbols++;
+    }
+    fclose(file);
+}
+
+//----------------------------------------------------------------------
+// Profiler::Symbolize
+// 	Put the name of an address in "buf": the symbol it falls in, and
+//	the offset from its start, or just the address in hex if there
+//	is no symbol table.
+// Returns:
+//	"buf".
+//----------------------------------------------------------------------
+
+char *
+Profiler::Symbolize(int addr, char *buf)
+{
+    int low = 0, high = numSymbols - 1, found = -1;
+
+    while (low <= high) {			// last symbol <= addr
+	int mid = (low + high) / 2;
+
+	if ((unsigned) symbolAddrs[mid] <= (unsigned) addr) {
+	    found = mid;
+	    low = mid + 1;
+	} else
+	    high = mid - 1;
+    }
+    if (found < 0)
+	sprintf(buf, "0x%x", addr);
+    else if (symbolAddrs[found] == addr)
+	sprintf(buf, "%s", symbolNames[found]);
+    else
+	sprintf(buf, "%s+0x%x", symbolNames[found], 
+		addr - symbolAddrs[found]);
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// Profiler::State
+// 	Return the profiler's state for the current thread, starting it
+//	at the root of the call-stack tree if this is its first
+//	instruction.
+//----------------------------------------------------------------------
+
+ProfileState *
+Profiler::State()
+{
+    ProfileState *state = currentThread->profile;
+
+    if (state == NULL) {
+	state = currentThread->profile = new ProfileState;
+	state->node = NULL;
+	state->block = -1;
+	state->lastPC = -1;
+    }
+    return state;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Executed
+// 	Count an instruction that has just been executed, by opcode, by
+//	PC, and by basic block; charge it to the function at the top of 
+//	the thread's call stack, and then follow any call or return.
+//
+//	A block's counts are found again for each instruction, rather 
+//	than kept in the thread, since the table may have grown -- and
+//	moved them -- while another thread ran.
+//
+//	"pc" is the instruction's address.
+//	"opCode" is what it was.
+//	"nextPC" is where execution goes after the delay slot -- for a
+//		call, the address of the function called.
+//	"jump" is whether the instruction was a call or a return.
+//----------------------------------------------------------------------
+
+void
+Profiler::Executed(int pc, int opCode, int nextPC, ProfileJump jump)
+{
+    ProfileState *state = State();
+    ProfileCounts *block;
+
+    ASSERT(opCode >= 0 && opCode < ProfileOpcodes);
+    opCounts[opCode]++;
+    numInstructions++;
+    pcs.Find(pc)->count++;
+
+    if (pc != state->lastPC + 4) {	// a new basic block
+	state->block = pc;
+	block = blocks.Find(pc);
+	block->count++;
+    } else
+	block = blocks.Find(state->block);
+    block->instructions++;
+    state->lastPC = pc;
+
+    if (state->node == NULL)		// the thread starts here
+	state->node = root->Child(pc);
+    state->node->instructions++;
+    if (jump == ProfileCall)
+	state->node = state->node->Child(nextPC);
+    else if (jump == ProfileReturn && state->node->parent != root)
+	state->node = state->node->parent;
+}
+
+//----------------------------------------------------------------------
+// Profiler::PageFault
+// 	Note that the exception being handled needs a page brought in;
+//	Stall charges its ticks to page faults rather than TLB misses.
+//----------------------------------------------------------------------
+
+void
+Profiler::PageFault()
+{
+    faulted = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Stall
+// 	Charge the ticks spent handling a TLB miss or a page fault to the
+//	instruction that caused it.  The instruction will be re-executed,
+//	and counted, once the handler returns.
+//----------------------------------------------------------------------
+
+void
+Profiler::Stall(int pc, int ticks)
+{
+    ProfileCounts *counts = pcs.Find(pc);
+
+    if (faulted) {
+	counts->pageFaults++;
+	counts->faultTicks += ticks;
+    } else {
+	counts->tlbMisses++;
+	counts->tlbTicks += ticks;
+    }
+    faulted = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Profiler::WriteStacks
+// 	Write one line for each function in a subtree of the call-stack
+//	tree that executed any instructions itself: the names on the 
+//	stack down to it, separated by ';', and the count.
+//
+//	"stack" holds the names above "node"; we append to it, and put
+//	it back as it was.
+//----------------------------------------------------------------------
+
+void
+Profiler::WriteStacks(FILE *file, ProfileNode *node, char *stack)
+{
+    char name[MaxSymbolLen + 16];
+    int len = strlen(stack);
+
+    Symbolize(node->entry, name);
+    if (len + strlen(name) + 2 >= MaxStackLen)
+	return;				// too deep to write
+    sprintf(stack + len, "%s%s", (len > 0) ? ";" : "", name);
+    if (node->instructions > 0)
+	fprintf(file, "%s %d\n", stack, node->instructions);
+    for (ProfileNode *child = node->children; child != NULL; 
+						child = child->sibling)
+	WriteStacks(file, child, stack);
+    stack[len] = '\0';
+}
+
+//----------------------------------------------------------------------
+// Profiler::Write
+// 	Write out the counts by opcode, by instruction and by basic 
+//	block, and the folded call stacks.
+//----------------------------------------------------------------------
+
+void
+Profiler::Write()
+{
+    FILE *file;
+    ProfileCounts **entries;
+    char name[MaxSymbolLen + 16];
+    char *stack;
+    int n, tlbTicks = 0, faultTicks = 0;
+
+    if ((file = fopen(fileName, "w")) == NULL) {
+	printf("Unable to open profile file %s\n", fileName);
+	return;
+    }
+
+    entries = pcs.Sorted(&n);
+    for (int i = 0; i < n; i++) {
+	tlbTicks += entries[i]->tlbTicks;
+	faultTicks += entries[i]->faultTicks;
+    }
+    fprintf(file, "# %d instructions; %d ticks lost to TLB misses, "
+	    "%d to page faults\n", numInstructions, tlbTicks, faultTicks);
+
+    fprintf(file, "\n# opcode count\n");
+    for (int op = 0; op < ProfileOpcodes; op++)
+	if (opCounts[op] > 0) {
+	    OpName(op, name, sizeof(name));
+	    fprintf(file, "%-8s %d\n", name, opCounts[op]);
+	}
+
+    fprintf(file, "\n# pc count tlb-misses tlb-ticks page-faults "
+	    "fault-ticks symbol\n");
+    for (int i = 0; i < n; i++)
+	fprintf(file, "0x%08x %d %d %d %d %d %s\n", entries[i]->addr, 
+		entries[i]->count, entries[i]->tlbMisses, 
+		entries[i]->tlbTicks, entries[i]->pageFaults, 
+		entries[i]->faultTicks, Symbolize(entries[i]->addr, name));
+    delete [] entries;
+
+    entries = blocks.Sorted(&n);
+    fprintf(file, "\n# block entries instructions symbol\n");
+    for (int i = 0; i < n; i++)
+	fprintf(file, "0x%08x %d %d %s\n", entries[i]->addr, 
+		entries[i]->count, entries[i]->instructions, 
+		Symbolize(entries[i]->addr, name));
+    delete [] entries;
+    fclose(file);
+
+    stack = new char[MaxStackLen];
+    sprintf(stack, "%s.folded", fileName);
+    if ((file = fopen(stack, "w")) == NULL)
+	printf("Unable to open profile file %s\n", stack);
+    else {
+	stack[0] = '\0';
+	for (ProfileNode *child = root->children; child != NULL; 
+						child = child->sibling)
+	    WriteStacks(file, child, stack);
+	fclose(file);
+    }
+    delete [] stack;
+    printf("Profile: %d instructions, written to %s\n", numInstructions,
+	   fileName);
+}
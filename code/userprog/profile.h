@@ -0,0 +1,145 @@
+// profile.h 
+//	Data structures for profiling user programs, one instruction at a
+//	time: how often each opcode, each instruction and each basic block
+//	is executed, how many ticks each instruction loses to TLB misses 
+//	and page faults, and how the instructions divide up among call 
+//	stacks.
+//
+//	Profiling is turned on with "-pf <file>"; the global "profiler" is 
+//	NULL otherwise, and the simulator's hooks cost only a test of that 
+//	pointer.  When the machine halts, the counts are written to the
+//	file, and the call stacks to "<file>.folded", one line per stack
+//	with its instruction count -- the input flamegraph.pl expects.
+//
+//	Addresses are written as symbols if a symbol table is given with
+//	"-ps <file>".  The table is the output of "nm -n" on the program's 
+//	COFF file (test/Makefile makes one with "make prog.sym"), since 
+//	coff2noff does not copy symbols into the NOFF file.
+//
+//	A basic block here is a run of instructions executed one after 
+//	another: a new one starts whenever the PC does not simply move on
+//	to the next word.  Calls are "jal" and "jalr", and returns are
+//	"jr $31".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define ProfileOpcodes	64		// > MaxOpcode, in mipssim.h
+#define ProfileInitialSize 1024		// initial size of the hash tables
+
+// How an instruction changes the call stack
+enum ProfileJump { ProfileStep, ProfileCall, ProfileReturn };
+
+// The following class defines the counts kept for one address -- an
+// instruction, or the start of a basic block.
+
+class ProfileCounts {
+  public:
+    int addr;				// the address counted
+    int count;				// times executed, or for a block, 
+					// times entered
+    int instructions;			// for a block, instructions executed
+    int tlbMisses, tlbTicks;		// TLB misses here, and ticks lost
+    int pageFaults, faultTicks;		// page faults here, and ticks lost
+};
+
+// The following class defines a hash table of counts, by address.  It
+// grows as needed.
+
+class ProfileTable {
+  public:
+    ProfileTable();
+    ~ProfileTable();
+
+    ProfileCounts *Find(int addr);	// the counts for "addr", added
+					// if need be
+    ProfileCounts **Sorted(int *n);	// every entry, by address; the
+					// caller deletes the array
+  private:
+    ProfileCounts *table;		// open addressing; addr -1 is empty
+    int size;				// # of slots, a power of two
+    int numEntries;			// # of slots in use
+
+    void Grow();			// double the size
+};
+
+// The following class defines a node in the tree of call stacks: a
+// function (by entry point), called from its parent's function.
+
+class ProfileNode {
+  public:
+    ProfileNode(int entryPC, ProfileNode *caller);
+    ~ProfileNode();			// de-allocate the subtree
+
+    ProfileNode *Child(int entryPC);	// the callee at "entryPC", added
+					// if need be
+
+    int entry;				// address of the function
+    int instructions;			// executed in it, not in callees
+    ProfileNode *parent;		// NULL at the root
+    ProfileNode *children;		// functions called from here
+    ProfileNode *sibling;		// next child of our parent
+};
+
+// The following class defines what the profiler keeps for each thread
+// running a user program.
+
+class ProfileState {
+  public:
+    ProfileNode *node;			// the function we are in
+    int block;				// start of the basic block we are in
+    int lastPC;				// the last instruction we executed
+};
+
+// The following class defines the profiler for one simulated machine.
+
+class Profiler {
+  public:
+    Profiler(char *outFile, char *symbolFile);
+    ~Profiler();
+
+    void Executed(int pc, int opCode, int nextPC, ProfileJump jump);
+					// the instruction at "pc" was
+					// executed, and will go on to 
+					// "nextPC" after its delay slot
+    void PageFault();			// the exception being handled 
+					// is a page fault, not a TLB miss
+    void Stall(int pc, int ticks);	// the instruction at "pc" lost 
+					// "ticks" to a TLB miss or page 
+					// fault
+    void Write();			// write out the results
+
+  private:
+    char *fileName;			// where the results go
+    int opCounts[ProfileOpcodes];	// executions, by opcode
+    ProfileTable pcs;			// counts, by instruction
+    ProfileTable blocks;		// counts, by basic block
+    ProfileNode *root;			// the tree of call stacks
+    int numInstructions;		// instructions executed, in all
+    bool faulted;			// page fault seen since the last
+					// Stall?
+
+    int numSymbols;			// the symbol table, by address
+    int *symbolAddrs;
+    char **symbolNames;
+
+    ProfileState *State();		// the current thread's state
+    void ReadSymbols(char *symbolFile);
+    char *Symbolize(int addr, char *buf);
+					// "name+offset", or the address
+    void WriteStacks(FILE *file, ProfileNode *node, char *stack);
+					// folded stacks for a subtree
+};
+
+extern void OpName(int opCode, char *buf, int size);
+					// the mnemonic for an opcode, from
+					// mipssim.cc
+
+#endif // PROFILE_H
@@ -80,9 +80,9 @@ void TestMultiThread(){
 }
 // Data structures needed for the console test.  Threads making
 // I/O requests wait on a Semaphore to delay until the I/O completes.
-static Console *console;
-static Semaphore *readAvail;
-static Semaphore *writeDone;
+static HostThreadLocal Console *console;
+static HostThreadLocal Semaphore *readAvail;
+static HostThreadLocal Semaphore *writeDone;
 
 //----------------------------------------------------------------------
 // ConsoleInterruptHandlers
@@ -36,6 +36,14 @@
 #define SC_Ls           15
 #define SC_Cd           16
 #define SC_Help         17
+#define SC_Sleep        18
+#define SC_FutexWait    19
+#define SC_FutexWake    20
+#define SC_Sync         21
+#define SC_Fsync        22
+#define SC_AioRead      23
+#define SC_AioWrite     24
+#define SC_AioWait      25
 
 #ifndef IN_ASM
 
@@ -120,6 +128,29 @@ int Read(char *buffer, int size, OpenFileId id);
 /* Close the file, we're done reading and writing to it. */
 void Close(OpenFileId id);
 
+/* Writes only reach the disk buffer cache; it writes them back to disk
+ * some time later.  Fsync returns once everything written to the open 
+ * file is on disk, and Sync once everything written to any file is.
+ */
+void Fsync(OpenFileId id);
+void Sync();
+
+/* Asynchronous I/O: AioRead and AioWrite start reading/writing "size" 
+ * bytes at offset "position" of an open file, and return at once, with
+ * an "AioId" for the request.  Many requests can be in flight at once,
+ * and the disk serves them in whatever order suits it.  AioWait waits
+ * for a request to finish, and returns the number of bytes actually
+ * read or written; only then is the data read in "buffer".  Every 
+ * request must be waited for exactly once, and before the file is
+ * closed.  The console cannot be used: AioRead and AioWrite return 0
+ * for it, and AioWait(0) returns -1.
+ */
+typedef int AioId;
+
+AioId AioRead(char *buffer, int size, int position, OpenFileId id);
+AioId AioWrite(char *buffer, int size, int position, OpenFileId id);
+int AioWait(AioId id);
+
 
 
 /* User-level thread operations: Fork and Yield.  To allow multiple
@@ -136,6 +167,22 @@ int Fork(void (*func)());
  */
 void Yield();		
 
+/* Put the calling thread to sleep for "ticks" units of simulated time,
+ * without using the CPU meanwhile.
+ */
+void Sleep(int ticks);
+
+/* Futexes, for building locks and condition variables in user programs
+ * (see test/usync.c).  FutexWait puts the calling thread to sleep on the
+ * word at "addr", but only if it still holds "expected"; it returns 0 
+ * after being woken up, or -1 right away if the word had changed.
+ * FutexWake wakes up to "count" threads sleeping on the word, and
+ * returns how many it woke.  Only threads of the same address space
+ * share a futex.
+ */
+int FutexWait(int *addr, int expected);
+int FutexWake(int *addr, int count);
+
 
 #endif /* IN_ASM */
 